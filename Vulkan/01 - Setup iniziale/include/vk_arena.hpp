@@ -0,0 +1,66 @@
+/**
+ * @file vk_arena.hpp
+ * @author Fabxx
+ * @brief Arena lineare per frame, per i dati dinamici di un fotogramma (uniform, parametri, dati temporanei).
+ * @version 0.1
+ * @date 2025-05-02
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+
+#pragma once
+
+#include <cstring>
+#include "vk_types.hpp"
+
+// Porzione dell'arena: puntatore per la CPU, buffer e offset per i descrittori, indirizzo per le shader.
+struct ArenaAllocation {
+    void* data;
+    VkBuffer buffer;
+    VkDeviceSize offset;
+    VkDeviceSize size;
+    VkDeviceAddress address;
+};
+
+/*
+* Arena lineare: un unico buffer mappato per tutta la sua vita, da cui ogni allocazione
+* prende la porzione successiva spostando un puntatore (bump allocator). Nessuna
+* chiamata a vmaCreateBuffer per i dati del frame e nessuna frammentazione.
+*
+* Le allocazioni rispettano minUniformBufferOffsetAlignment o minStorageBufferOffsetAlignment,
+* cosi possono essere usate anche come offset nei descrittori.
+*
+* Ogni FrameData ha la propria arena, resettata con reset() quando il frame che la usava
+* è stato completato dalla GPU. I dati allocati valgono quindi per un solo fotogramma.
+* Prima di inviare il frame, flush() rende visibili alla GPU le scritture se la memoria
+* non è coerente (con memoria HOST_COHERENT non fa nulla).
+*/
+struct FrameArena {
+    AllocatedBuffer buffer;
+    VkDeviceSize capacity;
+    VkDeviceSize head;
+    VkDeviceSize flushed;
+
+    VkDeviceSize uniformAlignment;
+    VkDeviceSize storageAlignment;
+
+    void init(VmaAllocator allocator, VkDeviceSize size, const VkPhysicalDeviceLimits& limits);
+    void destroy(VmaAllocator allocator);
+
+    void reset() { head = 0; flushed = 0; }
+    void flush(VmaAllocator allocator);
+
+    ArenaAllocation allocate(VkDeviceSize size, VkDeviceSize alignment);
+    ArenaAllocation allocate_uniform(VkDeviceSize size) { return allocate(size, uniformAlignment); }
+    ArenaAllocation allocate_storage(VkDeviceSize size) { return allocate(size, storageAlignment); }
+
+    // Copia value nell'arena, allineato come uno storage buffer (leggibile anche tramite indirizzo).
+    template<typename T>
+    ArenaAllocation push(const T& value)
+    {
+        ArenaAllocation allocation = allocate_storage(sizeof(T));
+        std::memcpy(allocation.data, &value, sizeof(T));
+        return allocation;
+    }
+};
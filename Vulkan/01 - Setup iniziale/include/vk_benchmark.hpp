@@ -0,0 +1,89 @@
+/**
+ * @file vk_benchmark.hpp
+ * @author Fabxx
+ * @brief Struttura che registra i tempi di ogni fotogramma e ne scrive un resoconto in CSV o JSON.
+ * @version 0.1
+ * @date 2025-05-02
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+
+#pragma once
+
+#include <chrono>
+#include <string>
+#include <vector>
+#include "vk_config.hpp"
+#include "vk_profiler.hpp"
+
+/*
+* Tempi misurati dalla CPU durante un singolo fotogramma, in millisecondi.
+*
+* frameMs:     intervallo tra l'inizio di questo fotogramma e quello precedente.
+* cpuMs:       tempo trascorso dentro draw().
+* fenceWaitMs: tempo passato ad attendere che la GPU liberi il frame (vkWaitForFences).
+* acquireMs:   tempo di vkAcquireNextImageKHR, 0 in headless.
+* submitMs:    tempo di vkQueueSubmit2.
+*/
+struct FrameTimings {
+    double frameMs;
+    double cpuMs;
+    double fenceWaitMs;
+    double acquireMs;
+    double submitMs;
+};
+
+/*
+* Registratore del benchmark.
+*
+* I primi warmupFrames fotogrammi vengono scartati, poiché contengono
+* la compilazione delle pipeline nei driver, le allocazioni iniziali ecc.
+*
+* Il benchmark termina dopo maxFrames fotogrammi misurati oppure dopo
+* maxSeconds secondi dalla fine del riscaldamento, quale arriva prima.
+* Un limite a 0 viene ignorato.
+*
+* Insieme ai tempi della CPU vengono registrati anche i tempi GPU dei blocchi
+* letti durante il fotogramma (appartengono ad un frame precedente, quello
+* appena completato). Ogni blocco diventa una colonna "gpu_<nome>_ms";
+* se in un fotogramma un blocco manca, il valore è NaN e non entra nelle statistiche.
+*/
+struct BenchmarkRecorder {
+
+    struct Summary {
+        double p50, p95, p99;
+        double mean, min, max;
+    };
+
+    uint32_t warmupFrames {0};
+    uint32_t maxFrames {0};
+    double maxSeconds {0.0};
+
+    uint32_t framesSeen {0};
+    std::chrono::steady_clock::time_point start;
+    std::vector<FrameTimings> samples;
+
+    std::vector<std::string> gpuScopeNames;
+    std::vector<std::vector<double>> gpuSamples;
+
+    void init(const EngineConfig& config);
+    void record(const FrameTimings& timings, const std::vector<GpuScopeTiming>& gpuTimings);
+    bool finished() const;
+
+    static Summary summarize(std::vector<double> values);
+
+    void print_summary() const;
+    bool write_report(const std::string& path) const;
+
+    private:
+        struct Column {
+            std::string name;
+            std::vector<double> values;
+        };
+
+        std::vector<Column> columns() const;
+
+        bool write_csv(const std::string& path) const;
+        bool write_json(const std::string& path) const;
+};
@@ -0,0 +1,83 @@
+/**
+ * @file vk_bindless.hpp
+ * @author Fabxx
+ * @brief Tabella globale dei descrittori (bindless): le risorse vengono registrate una volta
+ *        e le shader le indicizzano con un handle passato nei push constant.
+ * @version 0.1
+ * @date 2025-05-02
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include <vulkan/vulkan.hpp>
+
+/*
+* Allocatore di indici con lista libera: gli indici rilasciati vengono riusati
+* prima di prenderne di nuovi. Ritorna invalidIndex quando la tabella è piena.
+*/
+struct FreeListAllocator {
+    static constexpr uint32_t invalidIndex = ~0u;
+
+    uint32_t capacity {0};
+    uint32_t next {0};
+    std::vector<uint32_t> freeIndices;
+
+    uint32_t allocate();
+    void release(uint32_t index);
+};
+
+/*
+* Tabella bindless: un solo descriptor set con tre grandi array,
+* legato una volta per command buffer invece di un set per ogni dispatch.
+*
+* binding 0: storage image        (image2D storageImages[])
+* binding 1: immagini campionate  (sampler2D sampledImages[])
+* binding 2: storage buffer       (buffer ... storageBuffers[])
+*
+* I binding sono PARTIALLY_BOUND (gli elementi non registrati possono restare vuoti)
+* e UPDATE_AFTER_BIND (si possono registrare risorse mentre il set è legato in command
+* buffer non ancora eseguiti, purché non usino proprio quell'elemento).
+*
+* Le dimensioni degli array sono quelle richieste (max*) ridotte ai limiti UPDATE_AFTER_BIND
+* del dispositivo; la capacità effettiva è in storageImages.capacity e simili.
+* Quando un array è pieno le register_* ritornano FreeListAllocator::invalidIndex.
+*
+* Un indice rilasciato può essere riassegnato subito, quindi va rilasciato solo
+* quando nessun frame in volo lo usa più (ad esempio dalla deletion queue, con push_callback).
+* La tabella non è thread safe, va usata dal thread che registra i frame.
+*/
+struct BindlessHeap {
+    static constexpr uint32_t storageImageBinding = 0;
+    static constexpr uint32_t sampledImageBinding = 1;
+    static constexpr uint32_t storageBufferBinding = 2;
+
+    static constexpr uint32_t maxStorageImages = 1024;
+    static constexpr uint32_t maxSampledImages = 4096;
+    static constexpr uint32_t maxStorageBuffers = 4096;
+
+    VkDescriptorSetLayout layout;
+    VkDescriptorPool pool;
+    VkDescriptorSet set;
+
+    FreeListAllocator storageImages;
+    FreeListAllocator sampledImages;
+    FreeListAllocator storageBuffers;
+
+    void init(VkDevice device, VkPhysicalDevice physicalDevice, VkShaderStageFlags stages);
+    void destroy(VkDevice device);
+
+    uint32_t register_storage_image(VkDevice device, VkImageView view, VkImageLayout imageLayout = VK_IMAGE_LAYOUT_GENERAL);
+    uint32_t register_sampled_image(VkDevice device, VkImageView view, VkSampler sampler,
+                                    VkImageLayout imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+    uint32_t register_storage_buffer(VkDevice device, VkBuffer buffer, VkDeviceSize offset = 0,
+                                     VkDeviceSize range = VK_WHOLE_SIZE);
+
+    void release_storage_image(uint32_t index) { storageImages.release(index); }
+    void release_sampled_image(uint32_t index) { sampledImages.release(index); }
+    void release_storage_buffer(uint32_t index) { storageBuffers.release(index); }
+};
@@ -0,0 +1,21 @@
+/**
+ * @file vk_buffers.hpp
+ * @author Fabxx
+ * @brief Funzioni di creazione e distruzione dei buffer allocati tramite il VMA.
+ * @version 0.1
+ * @date 2025-05-02
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+
+#pragma once
+
+#include "vk_types.hpp"
+
+namespace vkutil {
+	AllocatedBuffer create_buffer(VmaAllocator allocator, size_t allocSize, VkBufferUsageFlags usage,
+								  VmaMemoryUsage memoryUsage, VmaAllocationCreateFlags flags = 0);
+
+	void destroy_buffer(VmaAllocator allocator, const AllocatedBuffer& buffer);
+}
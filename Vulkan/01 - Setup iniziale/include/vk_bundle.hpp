@@ -0,0 +1,98 @@
+/**
+ * @file vk_bundle.hpp
+ * @author Fabxx
+ * @brief Formato dell'archivio delle shader (shaders.bundle): un solo file con indice,
+ *        hash del contenuto e tutti i blob SPIR-V. Usato dall'engine e da tools/shader_bundler.cpp.
+ * @version 0.1
+ * @date 2025-05-02
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string>
+#include <string_view>
+#include "vk_files.hpp"
+
+/*
+* Struttura del file, tutti i valori sono little endian:
+*
+* ShaderBundleHeader
+* ShaderBundleEntry[entryCount]   ordinate per nome
+* tabella dei nomi                stringhe senza terminatore, una dopo l'altra
+* blob SPIR-V                     ognuno allineato a 8 byte
+*
+* Gli offset dei blob sono relativi all'inizio del file, quelli dei nomi
+* all'inizio della tabella dei nomi.
+*/
+struct ShaderBundleHeader {
+    static constexpr uint32_t magicValue = 0x42534B56; // "VKSB"
+    static constexpr uint32_t currentVersion = 1;
+
+    uint32_t magic;
+    uint32_t version;
+    uint32_t entryCount;
+    uint32_t namesSize;
+};
+
+struct ShaderBundleEntry {
+    uint32_t nameOffset;
+    uint32_t nameSize;
+    uint64_t offset;
+    uint64_t size;
+    uint64_t hash;
+};
+
+namespace vkutil {
+
+    /*
+    * Hash FNV-1a a 64 bit del contenuto di una shader.
+    * Non è crittografico, serve solo a capire se due blob SPIR-V sono uguali.
+    */
+    inline uint64_t hash_bytes(std::span<const std::byte> bytes)
+    {
+        uint64_t hash = 0xcbf29ce484222325ull;
+
+        for (std::byte b : bytes) {
+            hash ^= uint64_t(b);
+            hash *= 0x100000001b3ull;
+        }
+
+        return hash;
+    }
+}
+
+// Shader letta dall'archivio, code punta direttamente nella mappatura del file.
+struct BundledShader {
+    std::string_view name;
+    std::span<const uint32_t> code;
+    uint64_t hash;
+};
+
+/*
+* Archivio delle shader aperto in lettura.
+*
+* Il file viene mappato con una sola apertura, poi controlliamo intestazione e indice:
+* ogni blob deve stare dentro il file ed essere allineato, cosi le sue parole
+* si possono passare a vkCreateShaderModule senza copie.
+*
+* Le shader ritornate restano valide finché l'archivio è aperto.
+*/
+struct ShaderBundle {
+    MappedFile file;
+    std::string path;
+
+    bool open(const std::string& bundlePath);
+    void close();
+
+    // true se un file .spv di shaderDir è più recente dell'archivio.
+    bool is_outdated(const std::string& shaderDir) const;
+
+    uint32_t count() const;
+    BundledShader shader(uint32_t index) const;
+};
@@ -0,0 +1,38 @@
+/**
+ * @file vk_commands.hpp
+ * @author Fabxx
+ * @brief Command pool di un singolo thread, da cui registrare command buffer secondari in parallelo.
+ * @version 0.1
+ * @date 2025-05-02
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include <vulkan/vulkan.hpp>
+
+/*
+* Una command pool e i suoi command buffer non possono essere usati da più thread insieme,
+* quindi ogni worker del JobSystem ne ha una propria per ogni frame in volo.
+*
+* I command buffer secondari allocati restano nella pool e vengono riusati:
+* reset() azzera l'intera pool con una sola chiamata (vkResetCommandPool) quando
+* il frame che li ha usati è stato completato dalla GPU, invece di resettarli uno alla volta.
+*/
+struct ThreadCommandPool {
+    VkCommandPool pool;
+    std::vector<VkCommandBuffer> secondaries;
+    uint32_t used;
+
+    void init(VkDevice device, uint32_t queueFamily);
+    void destroy(VkDevice device);
+
+    void reset(VkDevice device);
+
+    // Restituisce un command buffer secondario già avviato, da chiudere con vkEndCommandBuffer.
+    VkCommandBuffer begin_secondary(VkDevice device);
+};
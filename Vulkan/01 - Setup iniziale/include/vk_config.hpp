@@ -0,0 +1,141 @@
+/**
+ * @file vk_config.hpp
+ * @author Fabxx
+ * @brief Opzioni di avvio dell'engine, lette dalla riga di comando.
+ * @version 0.1
+ * @date 2025-05-02
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+/*
+* Politica di presentazione della swapchain, tradotta in una VkPresentModeKHR
+* tra quelle supportate dalla superficie:
+*
+* Vsync:      FIFO, limitato al refresh del monitor, sempre supportato.
+* LowLatency: MAILBOX, nessun tearing e l'immagine più recente sostituisce quella in coda.
+* Uncapped:   IMMEDIATE, nessun limite e nessuna coda, con tearing. Per misurare il throughput reale.
+* Relaxed:    FIFO_RELAXED, come FIFO ma un fotogramma in ritardo viene presentato subito.
+*/
+enum class PresentPolicy {
+    Vsync,
+    LowLatency,
+    Uncapped,
+    Relaxed
+};
+
+/*
+* Struttura che contiene le opzioni con cui avviare l'engine.
+*
+* headless: non crea la finestra SDL, la superficie e la swapchain.
+*           Le immagini vengono renderizzate in target fuori schermo,
+*           utile sui server senza display o con un ICD software (lavapipe).
+*
+* frameCount: numero di fotogrammi da renderizzare prima di uscire, 0 = infiniti.
+*             In modalità headless, se non specificato, vengono renderizzati
+*             defaultHeadlessFrames fotogrammi.
+*
+* dumpPath: se impostato, in modalità headless l'ultimo fotogramma viene
+*           letto dalla GPU e salvato in formato PPM.
+*
+* benchmarkFrames / benchmarkSeconds: attivano il benchmark, che dopo warmupFrames
+*           fotogrammi di riscaldamento misura il numero di fotogrammi o i secondi
+*           indicati, poi scrive il resoconto in benchmarkOutput (.csv o .json) ed esce.
+*
+* gpuLogInterval: ogni quanti fotogrammi stampare i tempi GPU dei blocchi, 0 = mai.
+*
+* pipelineCachePath: file in cui salvare la cache delle pipeline, vuoto = non salvarla.
+*
+* workerThreads: numero di thread del JobSystem, 0 = uno per core meno uno.
+*
+* framesInFlight: fotogrammi che la CPU può preparare mentre la GPU lavora su quelli precedenti,
+*           da 1 (latenza minima) a maxFramesInFlight (throughput massimo).
+*           Con la finestra viene limitato al numero di immagini della swapchain.
+*
+* backgroundEffect: nome della compute shader di sfondo da usare all'avvio.
+*
+* fullBarriers: usa barriere complete (ALL_COMMANDS) come prima, per confrontare i tempi GPU.
+*
+* stagingMegabytes: dimensione in MB dell'anello di staging usato per caricare i dati sulla GPU.
+*
+* asyncCompute: usa una queue compute separata per lo sfondo, se il dispositivo ne ha una.
+*
+* memoryLogInterval: ogni quanti fotogrammi stampare budget e uso della memoria GPU, 0 = mai.
+* memoryDumpPath: file JSON in cui salvare le statistiche di VMA alla chiusura, vuoto = non salvarle.
+*           Con la finestra il tasto M le salva in qualsiasi momento (in memory_stats.json se vuoto).
+* memoryScaling: quando la memoria GPU è vicina al budget riduce la risoluzione di disegno.
+*
+* parallelRecording: i passaggi del frame vengono registrati in parallelo dai worker del JobSystem
+*           in command buffer secondari. Conviene quando i passaggi sono molti o pesanti da registrare.
+*
+* presentPolicy: modalità di presentazione desiderata, se non supportata si ripiega su FIFO.
+*
+* shaderDir: cartella dei file SPIR-V.
+* shaderBundle: archivio delle shader creato dal target ShaderBundle, vuoto = non usarlo.
+*           Il predefinito è quello della cartella di build (SHADER_BUNDLE_PATH, impostato da CMake),
+*           con --shaders <cartella> diventa <cartella>/shaders.bundle.
+*           Se manca, non è valido, è vuoto o più vecchio dei file .spv l'engine legge i file di shaderDir.
+* hotReload: osserva shaderDir e ricrea le pipeline delle shader modificate.
+*/
+struct EngineConfig {
+    static constexpr uint32_t defaultHeadlessFrames = 600;
+
+    uint32_t width {1280};
+    uint32_t height {720};
+
+    bool headless {false};
+    uint32_t frameCount {0};
+    std::string dumpPath;
+
+    uint32_t benchmarkFrames {0};
+    double benchmarkSeconds {0.0};
+    uint32_t warmupFrames {60};
+    std::string benchmarkOutput {"benchmark.csv"};
+
+    uint32_t gpuLogInterval {0};
+
+    std::string pipelineCachePath {"pipeline_cache.bin"};
+
+    uint32_t workerThreads {0};
+
+    static constexpr uint32_t maxFramesInFlight = 4;
+    uint32_t framesInFlight {2};
+
+    std::string backgroundEffect {"gradient_pixels"};
+
+    bool fullBarriers {false};
+    bool parallelRecording {false};
+    bool asyncCompute {true};
+    uint32_t stagingMegabytes {32};
+
+    uint32_t memoryLogInterval {0};
+    std::string memoryDumpPath;
+    bool memoryScaling {true};
+
+    PresentPolicy presentPolicy {PresentPolicy::Vsync};
+
+    std::string shaderDir {"shaders"};
+#ifdef SHADER_BUNDLE_PATH
+    std::string shaderBundle {SHADER_BUNDLE_PATH};
+#else
+    std::string shaderBundle;
+#endif
+    bool hotReload {false};
+
+    bool benchmark() const { return benchmarkFrames != 0 || benchmarkSeconds > 0.0; }
+};
+
+namespace vkConfig {
+    EngineConfig parse_args(int argc, char* argv[]);
+    void print_usage(const char* program);
+
+    bool parse_present_policy(std::string_view name, PresentPolicy& out);
+    const char* present_policy_name(PresentPolicy policy);
+}
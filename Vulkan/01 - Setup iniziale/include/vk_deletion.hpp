@@ -0,0 +1,95 @@
+/**
+ * @file vk_deletion.hpp
+ * @author Fabxx
+ * @brief Coda di distruzione differita degli oggetti Vulkan, senza allocazioni durante i frame.
+ * @version 0.1
+ * @date 2025-05-02
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include "vk_types.hpp"
+
+// Oggetto da distruggere: tipo, handle e, per immagini e buffer, la loro allocazione VMA.
+struct DeletionRecord {
+    VkObjectType type;
+    uint64_t handle;
+    VmaAllocation allocation;
+};
+
+// Operazione differita che non è un oggetto Vulkan (ad esempio liberare un indice bindless).
+struct DeletionCallback {
+    void (*function)(void* context, uint64_t value);
+    void* context;
+    uint64_t value;
+};
+
+/*
+* Coda di distruzione differita per gli oggetti ancora usati dai frame in volo.
+*
+* Invece di salvare una lambda per oggetto (una std::function, spesso allocata sull'heap)
+* salviamo dei record semplici in vettori contigui. I record aggiunti dopo l'ultimo close_batch()
+* formano il lotto aperto; close_batch(value) gli assegna il valore del semaforo timeline
+* dopo il quale la GPU non li usa più, tipicamente il valore segnalato dall'invio del frame.
+*
+* collect(completed) distrugge in blocco tutti i lotti con valore <= completed, in ordine
+* inverso di inserimento, e li toglie dai vettori senza liberarne la memoria: a regime
+* ritirare anche migliaia di oggetti per frame non alloca nulla. Il lotto aperto non viene
+* mai distrutto da collect(), qualunque sia il valore completato.
+*
+* flush() distrugge tutto senza guardare i valori, va chiamata solo con la GPU ferma.
+*/
+class DeletionQueue {
+
+    public:
+        void init(VkDevice device, VmaAllocator allocator);
+
+        void push(VkImage image, VmaAllocation allocation) { push_record(VK_OBJECT_TYPE_IMAGE, (uint64_t)image, allocation); }
+        void push(VkBuffer buffer, VmaAllocation allocation) { push_record(VK_OBJECT_TYPE_BUFFER, (uint64_t)buffer, allocation); }
+        void push(VkImageView view) { push_record(VK_OBJECT_TYPE_IMAGE_VIEW, (uint64_t)view); }
+        void push(VkSampler sampler) { push_record(VK_OBJECT_TYPE_SAMPLER, (uint64_t)sampler); }
+        void push(VkPipeline pipeline) { push_record(VK_OBJECT_TYPE_PIPELINE, (uint64_t)pipeline); }
+        void push(VkPipelineLayout layout) { push_record(VK_OBJECT_TYPE_PIPELINE_LAYOUT, (uint64_t)layout); }
+        void push(VkShaderModule module) { push_record(VK_OBJECT_TYPE_SHADER_MODULE, (uint64_t)module); }
+        void push(VkDescriptorSetLayout layout) { push_record(VK_OBJECT_TYPE_DESCRIPTOR_SET_LAYOUT, (uint64_t)layout); }
+        void push(VkDescriptorPool pool) { push_record(VK_OBJECT_TYPE_DESCRIPTOR_POOL, (uint64_t)pool); }
+        void push(VkCommandPool pool) { push_record(VK_OBJECT_TYPE_COMMAND_POOL, (uint64_t)pool); }
+        void push(VkSemaphore semaphore) { push_record(VK_OBJECT_TYPE_SEMAPHORE, (uint64_t)semaphore); }
+        void push(VkFence fence) { push_record(VK_OBJECT_TYPE_FENCE, (uint64_t)fence); }
+        void push(VkSwapchainKHR swapchain) { push_record(VK_OBJECT_TYPE_SWAPCHAIN_KHR, (uint64_t)swapchain); }
+
+        void push_callback(void (*function)(void* context, uint64_t value), void* context, uint64_t value);
+
+        void close_batch(uint64_t value);
+        void collect(uint64_t completedValue);
+        void flush();
+
+        size_t pending() const { return _records.size() + _callbacks.size(); }
+
+    private:
+        // Fine (esclusa) dei record e delle callback di un lotto chiuso.
+        struct Batch {
+            uint64_t value;
+            size_t recordEnd;
+            size_t callbackEnd;
+        };
+
+        void push_record(VkObjectType type, uint64_t handle, VmaAllocation allocation = nullptr)
+        {
+            _records.push_back({ type, handle, allocation });
+        }
+
+        void destroy(size_t recordCount, size_t callbackCount);
+
+        VkDevice _device {VK_NULL_HANDLE};
+        VmaAllocator _allocator {nullptr};
+
+        std::vector<DeletionRecord> _records;
+        std::vector<DeletionCallback> _callbacks;
+        std::vector<Batch> _batches;
+};
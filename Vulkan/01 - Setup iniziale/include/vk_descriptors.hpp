@@ -1,63 +1,70 @@
-/**
- * @file vk_init.hpp
- * @author Fabxx
- * @brief struttura che contiene funzioni per la creazione di Descriptor sets, per passare i dati alle shader.
- * 
- * 
- * @version 0.1
- * @date 2025-05-02
- * 
- * @copyright Copyright (c) 2025
- * 
- */
-
-#pragma once
-
-#include <vector>
-#include <VkBootstrap.h>
-#include <span>
-
-struct DescriptorLayoutBuilder {
-
-    std::vector<VkDescriptorSetLayoutBinding> bindings;
-
-    void add_binding(uint32_t binding, VkDescriptorType type);
-    void clear();
-    VkDescriptorSetLayout build(VkDevice device, VkShaderStageFlags shaderStages, 
-                                void* pNext = nullptr, VkDescriptorSetLayoutCreateFlags flags = 0);
-};
-
-
-/*
-* Struttura per allocare i descriptorSet.
-* 
-* Anzich avere un'unica pool che gestisce tutti i descriptor negli engine, 
-* 
-* creeremo diverse pool in base alle necessit. Poich i descriptorSet devono essere
-* pre-allocati, se usassimo una sola pool questo vorrebbe dire che avremmo bisogno
-* di sapere a priori che tipo di descriptorSet andremmo ad usare.
-* 
-* Quando distruggi una pool, elimini TUTTI i descriptorSet ad essa associati.
-* 
-* Utile per come come descrittori usati per-frame, avendo descrittori usati
-* per un solo fotogramma, allocati dinamicamente e prima di renderizzare il frame a schermo,
-* possiamo distruggerli poich non ci servono pi.
-* 
-* Questa tecnica  raccomandata dai costruttori delle GPU, in quanto  il metodo
-* pi performance per gestire i DescriptorSet per-frame.
-*/
-struct DescriptorAllocator {
-
-    struct PoolSizeRatio {
-        VkDescriptorType type;
-        float ratio;
-    };
-
-    VkDescriptorPool pool;
-
-    void init_pool(VkDevice device, uint32_t maxSets, std::span<PoolSizeRatio> poolRatios);
-    void clear_descriptors(VkDevice device);
-    void destroy_pool(VkDevice device);
-
-    VkDescriptorSet allocate(VkDevice device, VkDescriptorSetLayout layout);
-};
+/**
+ * @file vk_init.hpp
+ * @author Fabxx
+ * @brief struttura che contiene funzioni per la creazione di Descriptor sets, per passare i dati alle shader.
+ * 
+ * 
+ * @version 0.1
+ * @date 2025-05-02
+ * 
+ * @copyright Copyright (c) 2025
+ * 
+ */
+
+#pragma once
+
+#include <vector>
+#include <VkBootstrap.h>
+#include <span>
+
+struct DescriptorLayoutBuilder {
+
+    std::vector<VkDescriptorSetLayoutBinding> bindings;
+
+    void add_binding(uint32_t binding, VkDescriptorType type, uint32_t count = 1);
+    void clear();
+    VkDescriptorSetLayout build(VkDevice device, VkShaderStageFlags shaderStages, 
+                                void* pNext = nullptr, VkDescriptorSetLayoutCreateFlags flags = 0);
+};
+
+
+/*
+* Allocatore di descriptorSet che cresce quando serve.
+*
+* I descriptorSet vengono allocati da delle pool, e distruggere o resettare una pool
+* libera in un colpo tutti i descriptorSet allocati da essa. Invece di dover sapere a priori
+* quanti descriptorSet useremo, creiamo nuove pool in base alle necessità.
+*
+* Invece di una sola pool ne tiene due liste: quelle pronte, da cui allocare, e quelle piene.
+* Se l'allocazione fallisce perché la pool è esaurita (VK_ERROR_OUT_OF_POOL_MEMORY)
+* o frammentata (VK_ERROR_FRAGMENTED_POOL), la pool passa tra le piene e si riprova
+* con una nuova pool, grande una volta e mezza la precedente (fino a maxSetsPerPool).
+*
+* clear_pools() resetta tutte le pool con vkResetDescriptorPool e le rende di nuovo pronte:
+* con un allocatore per frame, resettato quando il frame è completato, i descriptorSet
+* temporanei di un fotogramma non costano quasi nulla.
+*/
+struct DescriptorAllocatorGrowable {
+
+    struct PoolSizeRatio {
+        VkDescriptorType type;
+        float ratio;
+    };
+
+    static constexpr uint32_t maxSetsPerPool = 4092;
+
+    void init(VkDevice device, uint32_t initialSets, std::span<PoolSizeRatio> poolRatios);
+    void clear_pools(VkDevice device);
+    void destroy_pools(VkDevice device);
+
+    VkDescriptorSet allocate(VkDevice device, VkDescriptorSetLayout layout, void* pNext = nullptr);
+
+    private:
+        VkDescriptorPool get_pool(VkDevice device);
+        VkDescriptorPool create_pool(VkDevice device, uint32_t setCount);
+
+        std::vector<PoolSizeRatio> ratios;
+        std::vector<VkDescriptorPool> fullPools;
+        std::vector<VkDescriptorPool> readyPools;
+        uint32_t setsPerPool;
+};
@@ -1,149 +1,361 @@
-/**
- * @file vk_engine.hpp
- * @author Fabxx
- * @brief Questa classe contiene gli oggetti principali di vulkan e le funzioni per inizializzare essi.
-          NOTA: il codice di setup viene fatto una sola volta, poi può essere copiato e incollato in 
-                altri progetti.
- * @version 0.1
- * @date 2025-05-02
- * 
- * @copyright Copyright (c) 2025
- * 
- */
-
-#pragma once
-
-#include <SDL2/SDL_video.h>
-#include <vulkan/vulkan.hpp>
-#include <deque>
-#include <functional>
-#include "vk_init.hpp"
-#include "vk_mem_alloc.h"
-#include "vk_descriptors.hpp"
-
-struct AllocatedImage {
-    VkImage image;
-    VkImageView imageView;
-    VmaAllocation allocation;
-    VkExtent3D imageExtent;
-    VkFormat imageFormat;
-};
-
-/*
-* Struttura che ci aiuta nella distruzione delle strutture
-* 
-*/
-struct DeletionQueue
-{
-    std::deque<std::function<void()>> deletors;
-
-    void push_function(std::function<void()>&& function) {
-        deletors.push_back(function);
-    }
-
-    void flush() {
-        // reverse iterate the deletion queue to execute all the functions
-        for (auto it = deletors.rbegin(); it != deletors.rend(); it++) {
-            (*it)(); //call functors
-        }
-
-        deletors.clear();
-    }
-};
-
-/*
-* Struttura che contiene i dati che renderizzeremo sulla finestra.
-* La useremo per creare più command buffer per lavorare in parallelo.
-*
-* FRAME_OVERLAP rappresenta il numero di buffer che andremo a creare.
-*
-* di conseguenza creeremo copie di struct che contengano ciascuna
-*
-* la sua pool, il suo buffer, i suoi semafori e la sua fence.
-*
-* il primo semaforo serve ad attendere la richiesta dell'immagine
-* da parte della swapchain prima di inoltrarla ad essa
-*
-* il secondo semaforo verrà usato per controllare la presentazione
-* dell'immagine al sistema operativo una volta che il disegno
-* è terminato.
-*
-* La renderFence ci farà attendere che tutti i comandi di disegno
-* di un frame finiscano.
-*/
-
-struct FrameData {
-    VkCommandPool commandPool;
-    VkCommandBuffer commandBuffer;
-
-    VkSemaphore _swapchainSemaphore, _renderSemaphore;
-    VkFence _renderFence;
-
-    DeletionQueue _deletionQueue;
-};
-
-
-constexpr unsigned int FRAME_OVERLAP = 2;
-
-class VulkanEngine {
-
-    public:
-        SDL_Window *window;
-        VkInstance _instance;
-        VkDebugUtilsMessengerEXT _debug_messenger;
-        VkPhysicalDevice _chosenGPU;
-        VkDevice _device;
-        VkSurfaceKHR _surface;
-
-        VkSwapchainKHR _swapchain;
-	    VkFormat _swapchainImageFormat;
-
-	    std::vector<VkImage> _swapchainImages;
-	    std::vector<VkImageView> _swapchainImageViews;
-	    VkExtent2D _swapchainExtent;
-        int _frameNumber{ 0 };
-
-        FrameData _frames[FRAME_OVERLAP];
-        FrameData& get_current_frame() { return _frames[_frameNumber % FRAME_OVERLAP]; };
-
-        VkQueue _graphicsQueue;
-        uint32_t _graphicsQueueFamily;
-
-        DeletionQueue _mainDeletionQueue;
-
-        VmaAllocator _allocator;
-
-        //draw resources
-        AllocatedImage _drawImage;
-        VkExtent2D _drawExtent;
-
-        DescriptorAllocator globalDescriptorAllocator;
-
-        VkDescriptorSet _drawImageDescriptors;
-        VkDescriptorSetLayout _drawImageDescriptorLayout;
-
-        VkPipeline _gradientPipeline;
-        VkPipelineLayout _gradientPipelineLayout;
-
-        bool bIsInitialized {false};
-        bool stop_rendering {false};
-
-        void init();
-        void run();
-        void draw();
-        void cleanup();
-
-    private:
-        void init_vulkan();
-        void init_swapchain();
-        void init_commands();
-        void init_sync_structures();
-        void init_pipelines();
-        void init_background_pipelines();
-        void init_descriptors();
-
-        void create_swapchain(uint32_t width, uint32_t height);
-	    void destroy_swapchain();
-
-        void draw_background(VkCommandBuffer cmd);
+/**
+ * @file vk_engine.hpp
+ * @author Fabxx
+ * @brief Questa classe contiene gli oggetti principali di vulkan e le funzioni per inizializzare essi.
+          NOTA: il codice di setup viene fatto una sola volta, poi può essere copiato e incollato in 
+                altri progetti.
+ * @version 0.1
+ * @date 2025-05-02
+ * 
+ * @copyright Copyright (c) 2025
+ * 
+ */
+
+#pragma once
+
+#include <SDL2/SDL_video.h>
+#include <vulkan/vulkan.hpp>
+#include <deque>
+#include <functional>
+#include "vk_init.hpp"
+#include "vk_mem_alloc.h"
+#include "vk_descriptors.hpp"
+#include "vk_bindless.hpp"
+#include "vk_types.hpp"
+#include "vk_config.hpp"
+#include "vk_benchmark.hpp"
+#include "vk_profiler.hpp"
+#include "vk_pipelines.hpp"
+#include "vk_jobs.hpp"
+#include "vk_commands.hpp"
+#include "vk_upload.hpp"
+#include "vk_arena.hpp"
+#include "vk_deletion.hpp"
+#include "vk_memory.hpp"
+#include "vk_submit.hpp"
+#include "vk_hotreload.hpp"
+#include "vk_images.hpp"
+#include "vk_rendergraph.hpp"
+
+/*
+* Struttura che ci aiuta nella distruzione delle strutture
+* 
+* La usiamo solo per gli oggetti creati all'avvio e distrutti alla chiusura, in ordine inverso.
+* Gli oggetti da distruggere mentre i frame sono in volo passano dalla DeletionQueue (vk_deletion.hpp).
+*/
+struct CleanupQueue
+{
+    std::deque<std::function<void()>> deletors;
+
+    void push_function(std::function<void()>&& function) {
+        deletors.push_back(std::move(function));
+    }
+
+    void flush() {
+        // reverse iterate the deletion queue to execute all the functions
+        for (auto it = deletors.rbegin(); it != deletors.rend(); it++) {
+            (*it)(); //call functors
+        }
+
+        deletors.clear();
+    }
+};
+
+/*
+* Struttura che contiene i dati che renderizzeremo sulla finestra.
+* La useremo per creare più command buffer per lavorare in parallelo.
+*
+* _framesInFlight rappresenta il numero di buffer che andremo a creare,
+* scelto all'avvio (--frames-in-flight).
+*
+* di conseguenza creeremo copie di struct che contengano ciascuna
+*
+* la sua pool, il suo buffer e il suo semaforo.
+*
+* il semaforo serve ad attendere la richiesta dell'immagine
+* da parte della swapchain prima di inoltrarla ad essa.
+*
+* I semafori di presentazione invece appartengono alle immagini della swapchain
+* (_presentSemaphores), e la fine di un frame si attende con il semaforo timeline
+* dell'engine (_frameTimeline), non più con una fence per frame.
+*
+* _gpuTimestamps contiene le query dei tempi GPU del frame, che leggiamo
+* dopo aver atteso che il frame precedente in questo slot sia completato.
+*
+* _frameArena è l'arena lineare da cui prendiamo i dati dinamici del frame (uniform, dati
+* temporanei), resettata quando lo slot viene riusato. _frameParameters è l'indirizzo dei
+* parametri del frame (FrameParameters) allocati nell'arena, letti dalle shader.
+*
+* Con una queue compute separata (_asyncCompute) lo sfondo viene registrato in
+* computeCommandBuffer, allocato da una pool della famiglia compute, con i propri timestamp.
+*/
+
+struct FrameData {
+    VkCommandPool commandPool;
+    VkCommandBuffer commandBuffer;
+
+    // una pool per worker del JobSystem (indice current_worker()), l'ultima per i thread esterni.
+    std::vector<ThreadCommandPool> _threadCommands;
+
+    VkSemaphore _swapchainSemaphore;
+
+    VkCommandPool computeCommandPool {VK_NULL_HANDLE};
+    VkCommandBuffer computeCommandBuffer {VK_NULL_HANDLE};
+    GpuTimestamps _computeTimestamps;
+
+    FrameArena _frameArena;
+    VkDeviceAddress _frameParameters;
+    GpuTimestamps _gpuTimestamps;
+};
+
+
+/*
+* Parametri del fotogramma letti dalle shader tramite puntatore (buffer device address).
+* La disposizione segue std430: drawExtent (uvec2) è allineato a 8 byte.
+*/
+struct FrameParameters {
+    float time;
+    uint32_t frameNumber;
+    uint32_t drawExtent[2];
+};
+
+/*
+* Push constant delle compute shader di sfondo:
+* indice nella tabella bindless dell'immagine su cui scrivere e indirizzo GPU
+* dei parametri del frame. L'indirizzo è a 64 bit, allineato a 8 byte come nella shader.
+*/
+struct BackgroundPushConstants {
+    uint32_t targetImage;
+    uint32_t padding;
+    VkDeviceAddress frameParameters;
+};
+
+
+/*
+* Fotogramma renderizzato in modalità headless e letto dalla GPU.
+*
+* pixels punta alla memoria del buffer di lettura, è valido solo durante
+* la chiamata alla callback, quindi se serve va copiato.
+* Le righe sono compatte, rowPitch = width * 4 byte (RGBA8).
+*/
+struct HeadlessFrame {
+    uint64_t frameNumber;
+    VkExtent2D extent;
+    VkFormat format;
+    const void* pixels;
+    size_t rowPitch;
+};
+
+using HeadlessFrameCallback = std::function<void(const HeadlessFrame&)>;
+
+/*
+* Target fuori schermo usato al posto delle immagini della swapchain.
+*
+* Ne creiamo uno per ogni frame in volo, cosi da non sovrascrivere un target
+* che la GPU sta ancora copiando. Il buffer di lettura viene creato solo se
+* è stata impostata una callback.
+*/
+struct HeadlessTarget {
+    AllocatedImage image;
+    AllocatedBuffer readback;
+    uint64_t frameNumber;
+    bool pending;
+};
+
+class VulkanEngine {
+
+    public:
+        EngineConfig _config;
+
+        SDL_Window *window {nullptr};
+        VkExtent2D _windowExtent {1280, 720};
+        VkInstance _instance;
+        VkDebugUtilsMessengerEXT _debug_messenger;
+        VkPhysicalDevice _chosenGPU;
+        VkDevice _device;
+        VkSurfaceKHR _surface {VK_NULL_HANDLE};
+
+        VkSwapchainKHR _swapchain {VK_NULL_HANDLE};
+	    VkFormat _swapchainImageFormat;
+
+	    std::vector<VkImage> _swapchainImages;
+	    std::vector<VkImageView> _swapchainImageViews;
+	    VkExtent2D _swapchainExtent;
+
+        /*
+        * Un semaforo di presentazione per ogni immagine della swapchain.
+        * Un semaforo per slot di frame potrebbe essere riutilizzato mentre la presentazione
+        * di un'altra immagine lo sta ancora attendendo, se le immagini vengono acquisite
+        * in un ordine diverso da quello degli slot.
+        */
+        std::vector<VkSemaphore> _presentSemaphores;
+
+        // la swapchain va ricostruita all'inizio del prossimo frame
+        // (finestra ridimensionata, OUT_OF_DATE o cambio della politica di presentazione).
+        bool _resizeRequested {false};
+        VkPresentModeKHR _presentMode {VK_PRESENT_MODE_FIFO_KHR};
+        int _frameNumber{ 0 };
+
+        // target della modalità headless, indicizzati come _frames.
+        // La callback va impostata prima di init(), altrimenti i buffer di lettura non vengono creati.
+        std::vector<HeadlessTarget> _headlessTargets;
+        HeadlessFrameCallback _headlessCallback;
+
+        // anello dei frame in volo, dimensionato da init_commands().
+        uint32_t _framesInFlight {2};
+        std::vector<FrameData> _frames;
+        FrameData& get_current_frame() { return _frames[_frameNumber % _framesInFlight]; };
+
+        /*
+        * Semaforo timeline dei frame: il frame N, quando la GPU lo completa, segnala il valore N + 1.
+        * Il valore cresce sempre, quindi da qualsiasi punto dell'engine si può sapere
+        * se un frame è terminato o attenderlo, senza fence da resettare.
+        */
+        VkSemaphore _frameTimeline {VK_NULL_HANDLE};
+
+        static uint64_t frame_timeline_value(uint64_t frameNumber) { return frameNumber + 1; }
+        bool is_frame_complete(uint64_t frameNumber) const;
+        void wait_for_frame(uint64_t frameNumber) const;
+
+        VkQueue _graphicsQueue;
+        uint32_t _graphicsQueueFamily;
+
+        /*
+        * Queue su cui gira la compute shader dello sfondo. Se il dispositivo non ha una famiglia
+        * compute separata coincide con la queue grafica e _asyncCompute è false.
+        *
+        * _computeTimeline viene segnalato con lo stesso valore di _frameTimeline quando lo sfondo
+        * del frame è pronto, e la queue grafica lo attende prima della copia.
+        */
+        VkQueue _computeQueue;
+        uint32_t _computeQueueFamily;
+        bool _asyncCompute {false};
+        uint32_t _computeTimestampValidBits {0};
+        VkSemaphore _computeTimeline {VK_NULL_HANDLE};
+
+        /*
+        * Queue di trasferimento usata dal caricatore: una famiglia solo trasferimento se esiste,
+        * altrimenti una famiglia senza grafica, altrimenti la queue grafica stessa.
+        */
+        VkQueue _transferQueue;
+        uint32_t _transferQueueFamily;
+        StagingUploader _uploader;
+
+        // Lavoro GPU fuori dal frame, inviato sulla queue grafica all'inizio di ogni frame.
+        SubmitBatcher _submitBatcher;
+
+        CleanupQueue _mainDeletionQueue;
+
+        /*
+        * Oggetti ancora usati dai frame in volo. Ogni frame chiude il proprio lotto con il valore
+        * che segnalerà sul semaforo _frameTimeline, e all'inizio dei frame successivi distruggiamo
+        * i lotti che la GPU ha già superato.
+        */
+        DeletionQueue _deletionQueue;
+
+        VmaAllocator _allocator;
+
+        /*
+        * Budget e uso della memoria GPU. Con la pressione sopra memoryHighWater riduciamo
+        * _renderScale, la frazione della swapchain in cui disegniamo, e ricreiamo l'immagine
+        * di disegno più piccola; sotto memoryLowWater torniamo gradualmente alla piena risoluzione.
+        */
+        MemoryMonitor _memoryMonitor;
+        bool _memoryBudgetSupported {false};
+        float _renderScale {1.0f};
+
+        static constexpr float memoryHighWater = 0.9f;
+        static constexpr float memoryLowWater = 0.7f;
+        static constexpr float renderScaleStep = 0.25f;
+        static constexpr float minRenderScale = 0.5f;
+
+        //draw resources
+        AllocatedImage _drawImage;
+        // layout e ultimo uso dell'immagine di disegno, aggiornati dalle barriere del frame.
+        ImageState _drawImageState {ImageState::undefined()};
+        // Conteggi del grafo dell'ultimo frame registrato, stampati insieme ai tempi GPU.
+        RenderGraph::Stats _renderGraphStats {};
+        VkExtent2D _drawExtent;
+
+        // tabella bindless di tutte le risorse e indice dell'immagine di disegno al suo interno.
+        BindlessHeap _bindless;
+        uint32_t _drawImageHandle;
+
+        // tutte le pipeline dell'engine, cercate per nome.
+        PipelineRegistry _pipelines;
+
+        // nomi degli effetti di sfondo in ordine alfabetico, e quello disegnato ora.
+        std::vector<std::string> _backgroundEffects;
+        std::string _backgroundEffect;
+
+        /*
+        * Pipeline in ricostruzione dopo la modifica di una shader.
+        * Vengono create dal JobSystem e sostituite nel registro all'inizio di un frame.
+        */
+        struct PendingReload {
+            std::string name;
+            std::future<PipelineEntry> result;
+            std::chrono::steady_clock::time_point detected;
+        };
+
+        ShaderWatcher _shaderWatcher;
+        std::vector<PendingReload> _pendingReloads;
+
+        JobSystem _jobs;
+
+        VkPhysicalDeviceProperties _gpuProperties;
+        PipelineCache _pipelineCache;
+
+        // tempi dell'ultimo fotogramma disegnato, registrati dal benchmark se attivo.
+        FrameTimings _lastFrameTimings {};
+        std::chrono::steady_clock::time_point _lastFrameStart;
+        std::chrono::steady_clock::time_point _engineStart;
+        BenchmarkRecorder _benchmark;
+
+        // tempi GPU dell'ultimo frame completato, per blocco.
+        std::vector<GpuScopeTiming> _gpuTimings;
+        float _timestampPeriod {1.0f};
+        uint32_t _timestampValidBits {0};
+
+        bool bIsInitialized {false};
+        bool stop_rendering {false};
+
+        void init(const EngineConfig& config = {});
+        void run();
+        bool draw();
+        void cleanup();
+
+    private:
+        void init_vulkan();
+        void init_swapchain();
+        void init_commands();
+        void init_sync_structures();
+        void init_pipelines();
+        void init_background_pipelines();
+        void init_descriptors();
+
+        void create_swapchain(uint32_t width, uint32_t height, VkSwapchainKHR oldSwapchain = VK_NULL_HANDLE);
+        void resize_swapchain();
+        VkPresentModeKHR choose_present_mode(PresentPolicy policy) const;
+        void cycle_present_policy();
+	    void destroy_swapchain();
+
+        void create_draw_image(VkExtent2D extent);
+        void retire_draw_image();
+        void register_draw_image();
+        VkExtent2D scaled_draw_extent() const;
+        void update_memory_pressure();
+        void update_frame_parameters();
+
+        void init_headless_targets();
+        void deliver_headless_frame(HeadlessTarget& target);
+
+        void draw_background(VkCommandBuffer cmd);
+        void submit_async_compute();
+        void cycle_background_effect(int step);
+        void process_shader_reloads();
+
+        void log_gpu_timings();
+        void run_windowed();
+        bool end_frame(uint32_t& framesDrawn);
 };
\ No newline at end of file
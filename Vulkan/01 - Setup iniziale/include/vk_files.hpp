@@ -0,0 +1,66 @@
+/**
+ * @file vk_files.hpp
+ * @author Fabxx
+ * @brief Lettura dei file mappandoli in memoria, senza copiarli in un buffer.
+ * @version 0.1
+ * @date 2025-05-02
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string>
+#include <utility>
+#include <vector>
+
+/*
+* File aperto in sola lettura e mappato in memoria (mmap su POSIX, CreateFileMapping su Windows).
+*
+* Il contenuto è accessibile da bytes() finché non chiamiamo close(): il sistema operativo
+* carica le pagine quando vengono lette, senza allocazioni né copie da parte nostra.
+* L'indirizzo di partenza è allineato alla pagina, quindi va bene per qualsiasi tipo di dato.
+*
+* La mappatura viene chiusa dal distruttore (o prima, con close()). Non si può copiare,
+* solo spostare: ogni mappatura ha un solo proprietario.
+*
+* Se un altro processo tronca il file mentre è mappato, leggere le pagine oltre la nuova
+* fine genera SIGBUS. Per i file che possono essere riscritti in qualsiasi momento
+* (le shader durante l'hot-reload) usiamo read_file_words, che ne fa una copia.
+*/
+struct MappedFile {
+    const std::byte* data {nullptr};
+    size_t size {0};
+
+#ifdef _WIN32
+    void* fileHandle {nullptr};
+    void* mappingHandle {nullptr};
+#endif
+
+    MappedFile() = default;
+    ~MappedFile() { close(); }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    MappedFile(MappedFile&& other) noexcept { *this = std::move(other); }
+    MappedFile& operator=(MappedFile&& other) noexcept;
+
+    bool open(const std::string& path);
+    void close();
+
+    std::span<const std::byte> bytes() const { return { data, size }; }
+};
+
+namespace vkutil {
+
+    /*
+    * Legge un file intero in parole da 32 bit, copiandolo. Fallisce se il file
+    * è vuoto, non leggibile o con dimensione non multipla di 4 byte.
+    */
+    bool read_file_words(const std::string& path, std::vector<uint32_t>& out);
+}
@@ -0,0 +1,57 @@
+/**
+ * @file vk_hotreload.hpp
+ * @author Fabxx
+ * @brief Osservatore della cartella delle shader, segnala i file SPIR-V modificati
+ *        cosi da ricreare le pipeline senza riavviare l'engine.
+ * @version 0.1
+ * @date 2025-05-02
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// File SPIR-V modificato e istante in cui ce ne siamo accorti.
+struct ShaderChange {
+    std::string path;
+    std::chrono::steady_clock::time_point detected;
+};
+
+/*
+* Osservatore dei file .spv di una cartella.
+*
+* Su Linux usiamo inotify: un thread in background attende gli eventi di chiusura
+* dopo la scrittura (IN_CLOSE_WRITE) e di spostamento nella cartella (IN_MOVED_TO),
+* che è il modo in cui molti compilatori sostituiscono il file.
+* Sugli altri sistemi il thread controlla la data di modifica dei file ogni 250 ms.
+*
+* Il thread principale legge le modifiche con poll_changes() tra un frame e l'altro,
+* senza mai bloccarsi. Più modifiche dello stesso file vengono unite in una sola.
+*/
+class ShaderWatcher {
+
+    public:
+        void start(const std::string& directory);
+        void stop();
+
+        std::vector<ShaderChange> poll_changes();
+
+    private:
+        void watch_loop();
+        void push_change(const std::string& path);
+
+        std::string _directory;
+        std::thread _thread;
+        std::atomic<bool> _running {false};
+
+        std::mutex _mutex;
+        std::vector<ShaderChange> _changes;
+};
@@ -1,27 +1,89 @@
-/**
- * @file vk_images.hpp
- * @author Fabxx
- * @brief Classe che contiene funzioni per gestire le transizioni delle immagini sul command
- *        buffer per sfurttare il rendering dinamico.
- * 
- *		  La transizione cambia da read a write per l'immagine.
- * @version 0.1
- * @date 2025-05-02
- *
- * @copyright Copyright (c) 2025
- *
- */
-
-#pragma once
-
-#include <vulkan/vulkan.hpp>
-
-namespace vkutil {
-	void transition_image(VkCommandBuffer cmd, VkImage image, 
-						  VkImageLayout currentLayout, VkImageLayout newLayout);
-
-	VkImageSubresourceRange image_subresource_range(VkImageAspectFlags aspectMask);
-
-	void copy_image_to_image(VkCommandBuffer cmd, VkImage source,
-		VkImage destination, VkExtent2D srcSize, VkExtent2D dstSize);
+/**
+ * @file vk_images.hpp
+ * @author Fabxx
+ * @brief Classe che contiene funzioni per gestire le transizioni delle immagini sul command
+ *        buffer per sfurttare il rendering dinamico.
+ * 
+ *		  La transizione cambia da read a write per l'immagine.
+ * @version 0.1
+ * @date 2025-05-02
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+
+#pragma once
+
+#include <vulkan/vulkan.hpp>
+#include <vector>
+
+/*
+* Stato di un'immagine per le barriere: il layout in cui si trova, e lo stage e l'accesso
+* dell'ultimo uso (per lo stato attuale) o del prossimo uso (per lo stato richiesto).
+*
+* Gli stati più usati dall'engine sono già definiti qui sotto.
+*/
+struct ImageState {
+    VkImageLayout layout;
+    VkPipelineStageFlags2 stage;
+    VkAccessFlags2 access;
+
+    // contenuto da scartare, nessun uso precedente da attendere.
+    static ImageState undefined() { return { VK_IMAGE_LAYOUT_UNDEFINED, VK_PIPELINE_STAGE_2_NONE, VK_ACCESS_2_NONE }; }
+
+    // immagine della swapchain appena acquisita: il semaforo di acquisizione viene atteso
+    // allo stage COLOR_ATTACHMENT_OUTPUT, la barriera deve partire da lì.
+    static ImageState acquired() { return { VK_IMAGE_LAYOUT_UNDEFINED, VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT, VK_ACCESS_2_NONE }; }
+
+    static ImageState compute_write() { return { VK_IMAGE_LAYOUT_GENERAL, VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT, VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT }; }
+    static ImageState transfer_src() { return { VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, VK_PIPELINE_STAGE_2_BLIT_BIT | VK_PIPELINE_STAGE_2_COPY_BIT, VK_ACCESS_2_TRANSFER_READ_BIT }; }
+    static ImageState transfer_dst() { return { VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_PIPELINE_STAGE_2_BLIT_BIT | VK_PIPELINE_STAGE_2_COPY_BIT, VK_ACCESS_2_TRANSFER_WRITE_BIT }; }
+
+    // la presentazione è ordinata dal semaforo passato a vkQueuePresentKHR, non serve uno stage.
+    static ImageState present() { return { VK_IMAGE_LAYOUT_PRESENT_SRC_KHR, VK_PIPELINE_STAGE_2_NONE, VK_ACCESS_2_NONE }; }
+};
+
+/*
+* Raccoglie le transizioni delle immagini e le invia con un'unica vkCmdPipelineBarrier2.
+*
+* Ogni barriera usa gli stage e gli accessi reali di chi ha prodotto e di chi userà
+* l'immagine (ad esempio scrittura compute -> lettura del blit), cosi la GPU attende
+* solo il lavoro necessario invece di svuotare tutta la pipeline.
+*
+* transition() aggiorna lo stato tracciato dell'immagine e salta le barriere inutili:
+* stesso layout e nessuna scrittura né prima né dopo.
+*
+* Con fullBarriers = true ogni barriera usa ALL_COMMANDS e MEMORY_READ/WRITE,
+* come la vecchia vkutil::transition_image, per confrontare i tempi GPU (--full-barriers).
+*
+* release() e acquire() trasferiscono la proprietà di un'immagine tra due famiglie di queue
+* (ad esempio compute -> grafica). Sono due barriere con gli stessi layout: release va registrata
+* sulla queue che cede l'immagine, acquire su quella che la riceve, dopo un semaforo tra le due.
+* Se il contenuto non serve (layout UNDEFINED) il trasferimento non è necessario.
+*/
+struct ImageBarrierBatch {
+    std::vector<VkImageMemoryBarrier2> barriers;
+    bool fullBarriers {false};
+
+    void transition(VkImage image, ImageState& state, const ImageState& next,
+                    VkImageAspectFlags aspectMask = VK_IMAGE_ASPECT_COLOR_BIT);
+    void release(VkImage image, const ImageState& state, VkImageLayout newLayout,
+                 uint32_t srcQueueFamily, uint32_t dstQueueFamily,
+                 VkImageAspectFlags aspectMask = VK_IMAGE_ASPECT_COLOR_BIT);
+    void acquire(VkImage image, ImageState& state, const ImageState& next,
+                 uint32_t srcQueueFamily, uint32_t dstQueueFamily,
+                 VkImageAspectFlags aspectMask = VK_IMAGE_ASPECT_COLOR_BIT);
+    void flush(VkCommandBuffer cmd);
+};
+
+namespace vkutil {
+	void transition_image(VkCommandBuffer cmd, VkImage image, 
+						  VkImageLayout currentLayout, VkImageLayout newLayout);
+
+	VkImageSubresourceRange image_subresource_range(VkImageAspectFlags aspectMask);
+
+	void copy_image_to_image(VkCommandBuffer cmd, VkImage source,
+		VkImage destination, VkExtent2D srcSize, VkExtent2D dstSize);
+
+	void copy_image_to_buffer(VkCommandBuffer cmd, VkImage source, VkBuffer destination, VkExtent2D size);
 }
\ No newline at end of file
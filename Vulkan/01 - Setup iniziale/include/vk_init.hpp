@@ -1,38 +1,47 @@
-/**
- * @file vk_init.hpp
- * @author Fabxx
- * @brief Classe che contiene funzioni helper per inizializzare le strutture.
- *        aiuta a rendere il codice principale meno verboso.
- * @version 0.1
- * @date 2025-05-02
- * 
- * @copyright Copyright (c) 2025
- * 
- */
-
-#pragma once
-
-#include "VkBootstrap.h"
-
-namespace vkInit {
-
-    // funzioni di creazione strutture info
-    VkFenceCreateInfo fenceInfo(VkFenceCreateFlagBits flags);
-    VkSemaphoreCreateInfo semaphoreInfo(VkSemaphoreCreateFlags flags);
-    VkCommandBufferBeginInfo commandBufferBeginInfo(VkCommandBufferUsageFlagBits flags);
-
-    // funzioni di invio strutture info
-    VkSemaphoreSubmitInfo semaphore_submit_info(VkPipelineStageFlags2 stageMask, VkSemaphore semaphore);
-    VkCommandBufferSubmitInfo command_buffer_submit_info(VkCommandBuffer cmd);
-    VkSubmitInfo2 submit_info(VkCommandBufferSubmitInfo* cmd, VkSemaphoreSubmitInfo* signalSemaphoreInfo,
-                                VkSemaphoreSubmitInfo* waitSemaphoreInfo);
-
-    // Funzioni di creazione di immagini separate dalla swapchain, per permettere scalatura e precisione di rendering
-    VkImageCreateInfo image_create_info(VkFormat format, VkImageUsageFlags usageFlags, VkExtent3D extent);
-    VkImageViewCreateInfo imageview_create_info(VkFormat format, VkImage image, VkImageAspectFlags aspectFlags);
-
-    // Funzione che carica le shader compilate in SPIR-V
-    bool load_shader_module(const char* filePath, VkDevice device, VkShaderModule* outShaderModule);
-
-    VkResult VK_CHECK(VkResult x);
+/**
+ * @file vk_init.hpp
+ * @author Fabxx
+ * @brief Classe che contiene funzioni helper per inizializzare le strutture.
+ *        aiuta a rendere il codice principale meno verboso.
+ * @version 0.1
+ * @date 2025-05-02
+ * 
+ * @copyright Copyright (c) 2025
+ * 
+ */
+
+#pragma once
+
+#include "VkBootstrap.h"
+#include <span>
+#include <cstdint>
+
+namespace vkInit {
+
+    // funzioni di creazione strutture info
+    VkFenceCreateInfo fenceInfo(VkFenceCreateFlagBits flags);
+    VkSemaphoreCreateInfo semaphoreInfo(VkSemaphoreCreateFlags flags);
+    VkCommandBufferBeginInfo commandBufferBeginInfo(VkCommandBufferUsageFlagBits flags);
+    VkCommandPoolCreateInfo command_pool_create_info(uint32_t queueFamilyIndex, VkCommandPoolCreateFlags flags);
+    VkCommandBufferAllocateInfo command_buffer_allocate_info(VkCommandPool pool, uint32_t count, VkCommandBufferLevel level);
+    VkCommandBufferInheritanceInfo command_buffer_inheritance_info();
+
+    // funzioni di invio strutture info
+    VkSemaphoreTypeCreateInfo timeline_semaphore_info(uint64_t initialValue);
+    VkSemaphoreSubmitInfo semaphore_submit_info(VkPipelineStageFlags2 stageMask, VkSemaphore semaphore, uint64_t value = 0);
+    VkCommandBufferSubmitInfo command_buffer_submit_info(VkCommandBuffer cmd);
+    VkSubmitInfo2 submit_info(VkCommandBufferSubmitInfo* cmd, VkSemaphoreSubmitInfo* signalSemaphoreInfo,
+                                VkSemaphoreSubmitInfo* waitSemaphoreInfo);
+    VkSubmitInfo2 submit_info(VkCommandBufferSubmitInfo* cmd, std::span<const VkSemaphoreSubmitInfo> signalSemaphoreInfos,
+                                std::span<const VkSemaphoreSubmitInfo> waitSemaphoreInfos);
+
+    // Funzioni di creazione di immagini separate dalla swapchain, per permettere scalatura e precisione di rendering
+    VkImageCreateInfo image_create_info(VkFormat format, VkImageUsageFlags usageFlags, VkExtent3D extent);
+    VkImageViewCreateInfo imageview_create_info(VkFormat format, VkImage image, VkImageAspectFlags aspectFlags);
+
+    // Funzioni che caricano le shader compilate in SPIR-V, da file o da parole già in memoria
+    bool load_shader_module(const char* filePath, VkDevice device, VkShaderModule* outShaderModule);
+    bool load_shader_module(std::span<const uint32_t> code, VkDevice device, VkShaderModule* outShaderModule);
+
+    VkResult VK_CHECK(VkResult x);
 };
\ No newline at end of file
@@ -0,0 +1,80 @@
+/**
+ * @file vk_jobs.hpp
+ * @author Fabxx
+ * @brief Thread pool semplice per eseguire lavori in parallelo (caricamento shader, creazione pipeline ecc.).
+ * @version 0.1
+ * @date 2025-05-02
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+/*
+* Sistema di lavori basato su un gruppo di thread fissi (worker).
+*
+* submit() mette in coda una funzione e ritorna un std::future con il suo risultato,
+* i worker prendono i lavori dalla coda in ordine di arrivo.
+*
+* Ogni worker ha un indice da 0 a worker_count() - 1, leggibile dal lavoro in esecuzione
+* con current_worker(). Serve per dare ad ogni thread le proprie risorse
+* (ad esempio una command pool), che Vulkan non permette di usare da più thread insieme.
+* I thread che non appartengono al sistema ottengono worker_count() come indice.
+*
+* Il distruttore chiama shutdown(), che si può chiamare più volte: anche uscendo senza
+* passare dalla pulizia dell'engine i worker vengono fermati e attesi, invece di
+* terminare il programma con dei std::thread ancora joinable.
+*/
+class JobSystem {
+
+    public:
+        JobSystem() = default;
+        ~JobSystem() { shutdown(); }
+
+        JobSystem(const JobSystem&) = delete;
+        JobSystem& operator=(const JobSystem&) = delete;
+
+        void init(uint32_t threadCount = 0);
+        void shutdown();
+
+        uint32_t worker_count() const { return uint32_t(_workers.size()); }
+        uint32_t current_worker() const;
+
+        template<typename F>
+        auto submit(F&& job) -> std::future<std::invoke_result_t<F>>
+        {
+            using Result = std::invoke_result_t<F>;
+
+            auto task = std::make_shared<std::packaged_task<Result()>>(std::forward<F>(job));
+            std::future<Result> result = task->get_future();
+
+            {
+                std::lock_guard<std::mutex> lock(_mutex);
+                _jobs.push_back([task]() { (*task)(); });
+            }
+            _condition.notify_one();
+
+            return result;
+        }
+
+    private:
+        void worker_loop(uint32_t index);
+
+        std::vector<std::thread> _workers;
+        std::deque<std::function<void()>> _jobs;
+        std::mutex _mutex;
+        std::condition_variable _condition;
+        bool _stopping {false};
+};
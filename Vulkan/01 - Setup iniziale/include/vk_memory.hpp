@@ -0,0 +1,69 @@
+/**
+ * @file vk_memory.hpp
+ * @author Fabxx
+ * @brief Monitor della memoria GPU: budget degli heap, memoria per categoria e statistiche di VMA.
+ * @version 0.1
+ * @date 2025-05-02
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "vk_types.hpp"
+
+// Categorie in cui dividiamo le allocazioni dell'engine.
+enum class MemoryCategory : uint32_t {
+    DrawTargets,
+    Staging,
+    FrameArenas,
+    Readback,
+    Count
+};
+
+const char* memory_category_name(MemoryCategory category);
+
+/*
+* Monitor della memoria GPU.
+*
+* poll() legge da VMA l'uso e il budget di ogni heap (vmaGetHeapBudgets). Con l'estensione
+* VK_EXT_memory_budget il budget è quello indicato dal driver, che tiene conto anche degli
+* altri processi, altrimenti VMA lo stima come l'80% della dimensione dell'heap.
+* Ritorna la pressione, cioè il rapporto uso / budget più alto tra gli heap locali della GPU.
+*
+* Le allocazioni registrate con track() vengono sommate per categoria, e ricevono il nome
+* della categoria anche in VMA, cosi compaiono nel JSON di dump_json() (vmaBuildStatsString).
+* log() stampa budget, categorie e totali di vmaCalculateStatistics, che scorre tutte le
+* allocazioni: va chiamata di rado.
+*/
+class MemoryMonitor {
+
+    public:
+        // ogni quanti fotogrammi l'engine controlla la pressione.
+        static constexpr uint32_t pollInterval = 60;
+
+        void init(VmaAllocator allocator);
+
+        void track(VmaAllocation allocation, MemoryCategory category);
+        void untrack(VmaAllocation allocation);
+
+        float poll(uint32_t frameIndex);
+        void log(uint64_t frameNumber) const;
+        bool dump_json(const std::string& path) const;
+
+    private:
+        struct TrackedAllocation {
+            VmaAllocation allocation;
+            MemoryCategory category;
+        };
+
+        VmaAllocator _allocator {nullptr};
+        const VkPhysicalDeviceMemoryProperties* _memoryProperties {nullptr};
+
+        std::vector<TrackedAllocation> _tracked;
+        VmaBudget _budgets[VK_MAX_MEMORY_HEAPS] {};
+};
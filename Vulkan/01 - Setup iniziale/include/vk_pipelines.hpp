@@ -1,14 +1,126 @@
-/**
- * @file vk_init.hpp
- * @author Fabxx
- * @brief Classe che contiene funzioni di creazione delle pipeline.
- * @version 0.1
- * @date 2025-05-02
- * 
- * @copyright Copyright (c) 2025
- * 
- */
-
-#pragma once
-
-#include "VkBootstrap.h"
+/**
+ * @file vk_init.hpp
+ * @author Fabxx
+ * @brief Classe che contiene funzioni di creazione delle pipeline.
+ * @version 0.1
+ * @date 2025-05-02
+ * 
+ * @copyright Copyright (c) 2025
+ * 
+ */
+
+#pragma once
+
+#include "VkBootstrap.h"
+#include <span>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "vk_jobs.hpp"
+#include "vk_bundle.hpp"
+
+/*
+* Cache delle pipeline salvata su disco tra un avvio e l'altro.
+*
+* La compilazione delle shader da parte del driver è la parte più lenta
+* della creazione di una pipeline. Il driver può salvare il risultato in una
+* VkPipelineCache, che passiamo a tutte le funzioni vkCreate*Pipelines.
+*
+* All'avvio carichiamo il file e controlliamo l'intestazione: il blob è valido solo
+* per lo stesso produttore, dispositivo e versione del driver (pipelineCacheUUID).
+* Se non combacia lo scartiamo e partiamo da una cache vuota (avvio "a freddo").
+*
+* Alla chiusura scriviamo il contenuto aggiornato della cache nel file.
+*/
+struct PipelineCache {
+    VkPipelineCache cache {VK_NULL_HANDLE};
+    std::string path;
+    bool warm {false};
+
+    void init(VkDevice device, const VkPhysicalDeviceProperties& properties, const std::string& filePath);
+    bool save(VkDevice device) const;
+    void destroy(VkDevice device);
+};
+
+/*
+* Descrizione di una compute pipeline da creare.
+*
+* name è il nome con cui la pipeline viene registrata, shaderPath il file SPIR-V
+* e layout il layout della pipeline già creato (condiviso tra più pipeline).
+*
+* Se code non è vuoto il SPIR-V arriva dall'archivio delle shader, con il suo hash
+* in codeHash, e shaderPath serve solo per i messaggi.
+* skipHash diverso da 0 evita di ricreare la pipeline se il contenuto ha quell'hash.
+*/
+struct ComputePipelineDesc {
+    std::string name;
+    std::string shaderPath;
+    VkPipelineLayout layout;
+    const char* entryPoint {"main"};
+
+    std::span<const uint32_t> code;
+    uint64_t codeHash {0};
+    uint64_t skipHash {0};
+
+    // legge il file con una copia invece di mapparlo: durante l'hot-reload il compilatore può riscriverlo.
+    bool copyFile {false};
+};
+
+/*
+* Voce del registro delle pipeline.
+*
+* Lo shader module resta in vita insieme alla pipeline, cosi possiamo ricreare
+* la pipeline (ad esempio con un layout diverso) senza rileggere il file.
+* Il layout invece appartiene al registro e può essere condiviso da più voci.
+*/
+struct PipelineEntry {
+    std::string name;
+    std::string shaderPath;
+    VkShaderModule module {VK_NULL_HANDLE};
+    VkPipelineLayout layout {VK_NULL_HANDLE};
+    VkPipeline pipeline {VK_NULL_HANDLE};
+    VkPipelineBindPoint bindPoint {VK_PIPELINE_BIND_POINT_COMPUTE};
+
+    // hash FNV-1a del SPIR-V, identifica il contenuto della shader (vedi vk_bundle.hpp).
+    uint64_t contentHash {0};
+};
+
+/*
+* Registro delle pipeline indicizzato per nome.
+*
+* Tutte le pipeline restano residenti, quindi passare da un effetto all'altro
+* durante il disegno costa solo una ricerca nella mappa e un vkCmdBindPipeline.
+*
+* Le voci non vengono mai rimosse, cosi l'indice di una voce resta valido
+* per tutta la vita del registro. Anche i layout vengono registrati per nome
+* e distrutti dal registro.
+*/
+struct PipelineRegistry {
+    static constexpr uint32_t invalidIndex = ~0u;
+
+    std::vector<PipelineEntry> entries;
+    std::unordered_map<std::string, uint32_t> byName;
+    std::unordered_map<std::string, VkPipelineLayout> layouts;
+
+    void add_layout(const std::string& name, VkPipelineLayout layout);
+    VkPipelineLayout find_layout(const std::string& name) const;
+
+    uint32_t add(VkDevice device, PipelineEntry entry);
+    PipelineEntry replace(uint32_t index, PipelineEntry entry);
+    uint32_t find_index(const std::string& name) const;
+    const PipelineEntry* find(const std::string& name) const;
+
+    void destroy(VkDevice device);
+};
+
+namespace vkutil {
+    std::string shader_name(const std::string& path);
+
+    std::vector<ComputePipelineDesc> find_compute_shaders(const std::string& shaderDir, VkPipelineLayout layout);
+    std::vector<ComputePipelineDesc> bundled_compute_shaders(const ShaderBundle& bundle, VkPipelineLayout layout);
+
+    PipelineEntry build_compute_pipeline(VkDevice device, VkPipelineCache cache, const ComputePipelineDesc& desc);
+
+    std::vector<PipelineEntry> build_compute_pipelines(VkDevice device, VkPipelineCache cache, JobSystem& jobs,
+                                                       std::span<const ComputePipelineDesc> descs);
+}
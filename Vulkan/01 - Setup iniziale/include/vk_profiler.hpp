@@ -0,0 +1,78 @@
+/**
+ * @file vk_profiler.hpp
+ * @author Fabxx
+ * @brief Strutture per misurare il tempo impiegato dalla GPU in ogni passaggio del fotogramma,
+ *        tramite una query pool di timestamp.
+ * @version 0.1
+ * @date 2025-05-02
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+
+#pragma once
+
+#include <vulkan/vulkan.hpp>
+#include <vector>
+
+// Tempo GPU di un blocco di comandi con nome, in millisecondi.
+struct GpuScopeTiming {
+    const char* name;
+    double ms;
+};
+
+/*
+* Timestamp di un singolo frame.
+*
+* Ogni FrameData ne possiede uno, cosi da leggere i risultati solo dopo che
+* quel frame è stato completato, senza mai bloccare la CPU.
+*
+* Ogni blocco usa due query: una all'inizio e una alla fine dei comandi.
+* I nomi devono essere stringhe costanti (letterali), poiché ne salviamo solo il puntatore.
+*
+* Se la queue non supporta i timestamp (timestampValidBits = 0) la pool non
+* viene creata e tutte le funzioni non fanno nulla. Altrimenti solo i timestampValidBits
+* bit più bassi sono validi: il contatore può ripartire da zero tra inizio e fine di un blocco,
+* quindi la differenza viene mascherata con validMask.
+*/
+struct GpuTimestamps {
+    static constexpr uint32_t maxScopes = 32;
+
+    VkQueryPool pool {VK_NULL_HANDLE};
+    uint64_t validMask {0};
+    uint32_t scopeCount {0};
+    const char* names[maxScopes] {};
+
+    void init(VkDevice device, uint32_t timestampValidBits);
+    void destroy(VkDevice device);
+
+    void reset(VkCommandBuffer cmd);
+    uint32_t begin_scope(VkCommandBuffer cmd, const char* name);
+    void end_scope(VkCommandBuffer cmd, uint32_t scope);
+
+    void collect(VkDevice device, float timestampPeriod, std::vector<GpuScopeTiming>& out);
+};
+
+/*
+* Blocco con nome misurato sulla GPU.
+*
+* Scrive il timestamp di inizio nel costruttore e quello di fine nel distruttore,
+* quindi per misurare un nuovo passaggio basta racchiuderlo tra parentesi graffe:
+*
+*   {
+*       GpuScope scope(frame._gpuTimestamps, cmd, "background");
+*       draw_background(cmd);
+*   }
+*/
+struct GpuScope {
+    GpuScope(GpuTimestamps& timestamps, VkCommandBuffer cmd, const char* name);
+    ~GpuScope();
+
+    GpuScope(const GpuScope&) = delete;
+    GpuScope& operator=(const GpuScope&) = delete;
+
+    private:
+        GpuTimestamps& _timestamps;
+        VkCommandBuffer _cmd;
+        uint32_t _scope;
+};
@@ -0,0 +1,102 @@
+/**
+ * @file vk_rendergraph.hpp
+ * @author Fabxx
+ * @brief Grafo dei passaggi di un frame: ogni passaggio dichiara le immagini che legge e scrive,
+ *        il grafo scarta quelli inutili e inserisce le barriere necessarie.
+ * @version 0.1
+ * @date 2025-05-02
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <vector>
+#include "vk_images.hpp"
+#include "vk_jobs.hpp"
+#include "vk_profiler.hpp"
+
+/*
+* Uso di un'immagine da parte di un passaggio: lo stato richiesto (layout, stage e accesso)
+* e se il passaggio ne legge il contenuto, lo scrive o entrambi.
+*/
+struct ImageAccess {
+    uint32_t image;
+    ImageState state;
+    bool read;
+    bool write;
+};
+
+/*
+* Grafo di un frame, costruito di nuovo ad ogni frame.
+*
+* 1) import_image() registra un'immagine insieme al suo stato tracciato. Lo stato vive fuori
+*    dal grafo (ad esempio nell'engine), cosi layout e ultimo uso passano da un frame al successivo.
+* 2) add_pass() aggiunge un passaggio con gli accessi alle immagini e la funzione che registra i comandi.
+*    I passaggi vengono eseguiti nell'ordine di dichiarazione, che deve rispettare le dipendenze:
+*    chi legge un'immagine va dichiarato dopo chi la scrive.
+* 3) mark_output() indica le immagini che servono fuori dal frame (swapchain, target di lettura)
+*    ed eventualmente lo stato in cui lasciarle.
+* 4) execute() scarta i passaggi che non contribuiscono a nessuna uscita e registra gli altri.
+*    Prima di ogni passaggio tutte le sue transizioni vengono inviate con un'unica barriera.
+*    Se il primo uso di un'immagine nel frame è una sola scrittura, il vecchio contenuto
+*    viene scartato (layout UNDEFINED).
+*
+* Con un JobSystem, execute() affida la registrazione di ogni passaggio ad un worker, in un command
+* buffer secondario ottenuto da beginSecondary (chiamata sul worker, deve usare la pool di quel thread).
+* Il thread chiamante intanto registra le barriere nel primario, poi inserisce i secondari in ordine
+* con vkCmdExecuteCommands. Le funzioni dei passaggi non devono quindi modificare lo stato dell'engine.
+*
+* Un passaggio con sideEffect = true non viene mai scartato (ad esempio una copia in un buffer
+* letto dalla CPU, che il grafo non traccia).
+*/
+struct RenderGraph {
+    using RecordFunction = std::function<void(VkCommandBuffer cmd)>;
+    using SecondaryFunction = std::function<VkCommandBuffer()>;
+
+    struct ImageResource {
+        const char* name;
+        VkImage image;
+        ImageState* state;
+        std::optional<ImageState> finalState;
+        bool output;
+    };
+
+    struct Pass {
+        const char* name;
+        std::vector<ImageAccess> accesses;
+        RecordFunction record;
+        bool sideEffect;
+        bool culled;
+    };
+
+    // Conteggi dell'ultima esecuzione, per controllare che le barriere restino poche.
+    struct Stats {
+        uint32_t passes;
+        uint32_t culledPasses;
+        uint32_t barriers;
+        uint32_t barrierCalls;
+    };
+
+    std::vector<ImageResource> images;
+    std::vector<Pass> passes;
+    Stats stats {};
+
+    static ImageAccess read(uint32_t image, const ImageState& state) { return { image, state, true, false }; }
+    static ImageAccess write(uint32_t image, const ImageState& state) { return { image, state, false, true }; }
+    static ImageAccess read_write(uint32_t image, const ImageState& state) { return { image, state, true, true }; }
+
+    uint32_t import_image(const char* name, VkImage image, ImageState& state);
+    void add_pass(const char* name, std::vector<ImageAccess> accesses, RecordFunction record, bool sideEffect = false);
+    void mark_output(uint32_t image, std::optional<ImageState> finalState = std::nullopt);
+
+    void execute(VkCommandBuffer cmd, GpuTimestamps& timestamps, bool fullBarriers,
+                 JobSystem* jobs = nullptr, SecondaryFunction beginSecondary = {});
+
+    private:
+        void cull();
+};
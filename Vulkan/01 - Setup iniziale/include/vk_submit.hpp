@@ -0,0 +1,82 @@
+/**
+ * @file vk_submit.hpp
+ * @author Fabxx
+ * @brief Invio raggruppato del lavoro GPU fuori dal frame (clear, generazione mipmap ecc.),
+ *        con handle da controllare o attendere sul semaforo timeline.
+ * @version 0.1
+ * @date 2025-05-02
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <vector>
+#include <vulkan/vulkan.hpp>
+
+/*
+* Handle di un lavoro inviato alla GPU: è completato quando il semaforo timeline
+* raggiunge value. Un handle vuoto (value = 0) risulta sempre completato.
+*/
+struct GpuFuture {
+    VkDevice device {VK_NULL_HANDLE};
+    VkSemaphore timeline {VK_NULL_HANDLE};
+    uint64_t value {0};
+
+    bool is_ready() const;
+    void wait() const;
+};
+
+/*
+* Raccoglie tante piccole richieste di lavoro GPU e le registra in un solo command buffer,
+* inviato con un'unica vkQueueSubmit2 da flush(), invece di una fence e una vkQueueWaitIdle
+* per ogni richiesta.
+*
+* submit() può essere chiamata da qualsiasi thread: la funzione viene solo messa in coda
+* e registrata più tardi da flush(), sul thread che usa la queue (quello dei frame).
+* Ritorna subito un GpuFuture con il valore che il gruppo segnalerà.
+*
+* GpuFuture::wait() su un gruppo non ancora inviato attende finché il thread dei frame non
+* chiama flush(). Sul thread dei frame va usata SubmitBatcher::wait(), che prima invia il gruppo.
+*/
+class SubmitBatcher {
+
+    public:
+        using RecordFunction = std::function<void(VkCommandBuffer cmd)>;
+
+        void init(VkDevice device, VkQueue queue, uint32_t queueFamily);
+        void destroy();
+
+        GpuFuture submit(RecordFunction record);
+
+        // Invia le richieste in coda e ritorna il valore segnalato, 0 se non c'era nulla da inviare.
+        uint64_t flush();
+        void wait(const GpuFuture& future);
+
+        VkSemaphore timeline() const { return _timeline; }
+
+    private:
+        struct Batch {
+            VkCommandBuffer cmd;
+            uint64_t value;
+        };
+
+        void retire_completed();
+
+        VkDevice _device;
+        VkQueue _queue;
+        VkCommandPool _commandPool;
+        VkSemaphore _timeline;
+
+        std::mutex _mutex;
+        std::vector<RecordFunction> _requests;
+        uint64_t _nextValue {1};
+
+        std::vector<VkCommandBuffer> _freeCommandBuffers;
+        std::deque<Batch> _inFlight;
+};
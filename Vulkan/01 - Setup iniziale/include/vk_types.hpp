@@ -0,0 +1,40 @@
+/**
+ * @file vk_types.hpp
+ * @author Fabxx
+ * @brief Tipi di base condivisi da tutto l'engine (immagini e buffer allocati con il VMA).
+ * @version 0.1
+ * @date 2025-05-02
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+
+#pragma once
+
+#include <vulkan/vulkan.hpp>
+#include "vk_mem_alloc.h"
+
+struct AllocatedImage {
+    VkImage image;
+    VkImageView imageView;
+    VmaAllocation allocation;
+    VkExtent3D imageExtent;
+    VkFormat imageFormat;
+};
+
+/*
+* Buffer allocato con il VMA.
+*
+* info contiene, tra le altre cose, il puntatore pMappedData
+* se il buffer è stato creato con il flag VMA_ALLOCATION_CREATE_MAPPED_BIT.
+*
+* address è l'indirizzo del buffer nella memoria della GPU, valido solo se creato con
+* VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT (altrimenti 0). Le shader lo usano come
+* puntatore (GL_EXT_buffer_reference), senza descrittori.
+*/
+struct AllocatedBuffer {
+    VkBuffer buffer;
+    VmaAllocation allocation;
+    VmaAllocationInfo info;
+    VkDeviceAddress address;
+};
@@ -0,0 +1,120 @@
+/**
+ * @file vk_upload.hpp
+ * @author Fabxx
+ * @brief Caricamento di buffer e immagini nella memoria della GPU tramite un buffer di staging
+ *        ad anello e una queue di trasferimento dedicata.
+ * @version 0.1
+ * @date 2025-05-02
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <vector>
+#include "vk_types.hpp"
+#include "vk_images.hpp"
+
+/*
+* Caricatore dei dati dalla CPU alla GPU.
+*
+* upload_buffer() e upload_image() copiano i dati in un buffer di staging mappato per tutta
+* la sua vita (l'anello) e accodano la copia verso la destinazione. Le copie accodate vengono
+* inviate insieme, in un solo command buffer, da flush() sulla queue di trasferimento.
+*
+* Ogni caricamento ritorna un valore del semaforo timeline del caricatore: la copia è completata
+* quando il semaforo lo raggiunge. Lo spazio dell'anello viene riusato solo dopo, e se finisce
+* attendiamo i caricamenti più vecchi. Un caricamento più grande dell'intero anello usa un
+* buffer di staging temporaneo.
+*
+* Se la queue di trasferimento appartiene ad una famiglia diversa da quella grafica, le risorse
+* caricate vengono rilasciate dalla queue di trasferimento e acquisite da quella grafica:
+* acquire_completed(), all'inizio del command buffer del frame, registra le acquisizioni dei
+* caricamenti completati e ritorna il valore del semaforo da attendere nell'invio del frame.
+* Una risorsa si può usare dal primo frame in cui is_ready() ritorna true.
+*
+* Il caricatore non è thread safe, va usato dal thread che registra i frame.
+*/
+struct StagingUploader {
+
+    /*
+    * Gruppo di copie inviate insieme.
+    * consumed sono i byte dell'anello occupati, padding compreso, liberati al completamento.
+    */
+    struct Batch {
+        VkCommandBuffer cmd;
+        uint64_t value;
+        size_t consumed;
+        std::vector<AllocatedBuffer> oversized;
+        std::vector<VkBufferMemoryBarrier2> bufferAcquires;
+        std::vector<VkImageMemoryBarrier2> imageAcquires;
+    };
+
+    // Statistiche dall'avvio, per verificare che l'anello sia dimensionato bene.
+    struct Stats {
+        uint64_t uploads;
+        uint64_t bytes;
+        uint64_t batches;
+        uint64_t stalls;
+        uint64_t oversized;
+    };
+
+    static constexpr size_t alignment = 16;
+
+    void init(VkDevice device, VmaAllocator allocator, VkQueue queue, uint32_t queueFamily,
+              uint32_t graphicsQueueFamily, size_t ringSize);
+    void destroy();
+
+    uint64_t upload_buffer(const void* data, size_t size, VkBuffer destination, VkDeviceSize destinationOffset = 0);
+    uint64_t upload_image(const void* data, size_t size, VkImage destination, VkExtent3D extent,
+                          const ImageState& finalState, VkImageAspectFlags aspectMask = VK_IMAGE_ASPECT_COLOR_BIT);
+
+    void flush();
+    uint64_t acquire_completed(VkCommandBuffer cmd);
+
+    bool is_ready(uint64_t value) const { return value <= _acquiredValue; }
+    bool is_complete(uint64_t value) const;
+    void wait(uint64_t value) const;
+
+    VkSemaphore timeline() const { return _timeline; }
+    const Stats& stats() const { return _stats; }
+    VmaAllocation ring_allocation() const { return _ring.allocation; }
+
+    private:
+        bool transfers_ownership() const { return _queueFamily != _graphicsQueueFamily; }
+
+        VkCommandBuffer pending_command_buffer();
+        VkDeviceSize stage(const void* data, size_t size, VkBuffer& stagingBuffer);
+        void retire_completed();
+
+        VkDevice _device;
+        VmaAllocator _allocator;
+        VkQueue _queue;
+        uint32_t _queueFamily;
+        uint32_t _graphicsQueueFamily;
+
+        VkCommandPool _commandPool;
+        std::vector<VkCommandBuffer> _freeCommandBuffers;
+
+        AllocatedBuffer _ring;
+        size_t _ringSize;
+        size_t _head;
+        size_t _used;
+
+        VkSemaphore _timeline;
+        uint64_t _nextValue;
+        uint64_t _acquiredValue;
+
+        Batch _pending;
+        bool _hasPending;
+        std::deque<Batch> _inFlight;
+
+        std::vector<VkBufferMemoryBarrier2> _readyBufferAcquires;
+        std::vector<VkImageMemoryBarrier2> _readyImageAcquires;
+        uint64_t _readyValue;
+
+        Stats _stats;
+};
@@ -1,19 +1,67 @@
-#include "../include/vk_engine.hpp"
-
-/*
-* NOTA: La macro per il VMA va definita solo in un file CPP, e insieme va incluso l'header C
-*       della libreria
-* 
-* Poi nei file dove richiami i tipi di dati del VMA includi la libreria hpp soltanto.
-*/
-#define VMA_IMPLEMENTATION
-#include "vk_mem_alloc.h"
-
-int main(void) {
-
-    VulkanEngine vkEngine;
-
-    vkEngine.init();
-    vkEngine.run();
-    vkEngine.cleanup();
-}
\ No newline at end of file
+#include "../include/vk_engine.hpp"
+#include <cstring>
+#include <fstream>
+#include <vector>
+
+/*
+* NOTA: La macro per il VMA va definita solo in un file CPP, e insieme va incluso l'header C
+*       della libreria
+* 
+* Poi nei file dove richiami i tipi di dati del VMA includi la libreria hpp soltanto.
+*/
+#define VMA_IMPLEMENTATION
+#include "vk_mem_alloc.h"
+
+/*
+* Salva un fotogramma RGBA8 in formato PPM (binario), scartando il canale alfa.
+*/
+static void write_ppm(const std::string& path, const HeadlessFrame& frame)
+{
+    std::ofstream file(path, std::ios::binary);
+
+    file << "P6\n" << frame.extent.width << " " << frame.extent.height << "\n255\n";
+
+    const char* row = static_cast<const char*>(frame.pixels);
+    for (uint32_t y = 0; y < frame.extent.height; y++, row += frame.rowPitch) {
+        for (uint32_t x = 0; x < frame.extent.width; x++) {
+            file.write(row + x * 4, 3);
+        }
+    }
+}
+
+int main(int argc, char* argv[]) {
+
+    EngineConfig config = vkConfig::parse_args(argc, argv);
+
+    VulkanEngine vkEngine;
+
+    /*
+    * In headless salviamo solo l'ultimo fotogramma renderizzato.
+    * Con --frames 0 o con il benchmark non sappiamo in anticipo quale sarà l'ultimo,
+    * quindi teniamo una copia del più recente e lo scriviamo all'uscita, dopo cleanup(),
+    * che consegna anche i fotogrammi ancora in attesa.
+    */
+    HeadlessFrame lastFrame {};
+    std::vector<char> lastPixels;
+
+    if (config.headless && !config.dumpPath.empty()) {
+        vkEngine._headlessCallback = [&lastFrame, &lastPixels](const HeadlessFrame& frame) {
+            if (!lastPixels.empty() && frame.frameNumber < lastFrame.frameNumber) {
+                return;
+            }
+
+            lastFrame = frame;
+            lastPixels.resize(frame.rowPitch * frame.extent.height);
+            std::memcpy(lastPixels.data(), frame.pixels, lastPixels.size());
+            lastFrame.pixels = lastPixels.data();
+        };
+    }
+
+    vkEngine.init(config);
+    vkEngine.run();
+    vkEngine.cleanup();
+
+    if (!lastPixels.empty()) {
+        write_ppm(config.dumpPath, lastFrame);
+    }
+}
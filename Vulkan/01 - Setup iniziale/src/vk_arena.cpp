@@ -0,0 +1,59 @@
+#include "../include/vk_arena.hpp"
+#include "../include/vk_buffers.hpp"
+#include <algorithm>
+#include <fmt/core.h>
+
+/*
+* Il buffer può essere usato come uniform, come storage e tramite indirizzo.
+* Gli allineamenti sono almeno 16 byte, quanto serve ai vec4 in std430.
+*/
+void FrameArena::init(VmaAllocator allocator, VkDeviceSize size, const VkPhysicalDeviceLimits& limits)
+{
+	buffer = vkutil::create_buffer(allocator, size,
+		VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT,
+		VMA_MEMORY_USAGE_CPU_TO_GPU, VMA_ALLOCATION_CREATE_MAPPED_BIT);
+
+	capacity = size;
+	uniformAlignment = std::max<VkDeviceSize>(limits.minUniformBufferOffsetAlignment, 16);
+	storageAlignment = std::max<VkDeviceSize>(limits.minStorageBufferOffsetAlignment, 16);
+
+	reset();
+}
+
+void FrameArena::destroy(VmaAllocator allocator)
+{
+	vkutil::destroy_buffer(allocator, buffer);
+}
+
+/*
+* Gli allineamenti dei limiti sono sempre potenze di 2.
+* Un'arena piena è un errore di dimensionamento: fermiamo il programma come VK_CHECK.
+*/
+ArenaAllocation FrameArena::allocate(VkDeviceSize size, VkDeviceSize alignment)
+{
+	VkDeviceSize offset = (head + alignment - 1) & ~(alignment - 1);
+
+	if (offset + size > capacity) {
+		fmt::print("Arena del frame piena: richiesti {} byte, capacità {}\n", size, capacity);
+		abort();
+	}
+
+	head = offset + size;
+
+	ArenaAllocation allocation{};
+	allocation.data = static_cast<char*>(buffer.info.pMappedData) + offset;
+	allocation.buffer = buffer.buffer;
+	allocation.offset = offset;
+	allocation.size = size;
+	allocation.address = buffer.address + offset;
+
+	return allocation;
+}
+
+void FrameArena::flush(VmaAllocator allocator)
+{
+	if (head > flushed) {
+		vmaFlushAllocation(allocator, buffer.allocation, flushed, head - flushed);
+		flushed = head;
+	}
+}
@@ -0,0 +1,262 @@
+#include "../include/vk_benchmark.hpp"
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <numeric>
+#include <fmt/core.h>
+#include <fmt/format.h>
+
+/*
+* Elenco delle colonne del resoconto, con il campo di FrameTimings corrispondente.
+* Aggiungendo un campo alla struttura basta aggiungerlo qui per averlo nel CSV e nel JSON.
+*/
+struct TimingColumn {
+    const char* name;
+    double FrameTimings::* field;
+};
+
+static constexpr TimingColumn timingColumns[] = {
+    { "frame_ms",      &FrameTimings::frameMs },
+    { "cpu_ms",        &FrameTimings::cpuMs },
+    { "fence_wait_ms", &FrameTimings::fenceWaitMs },
+    { "acquire_ms",    &FrameTimings::acquireMs },
+    { "submit_ms",     &FrameTimings::submitMs },
+};
+
+void BenchmarkRecorder::init(const EngineConfig& config)
+{
+    warmupFrames = config.warmupFrames;
+    maxFrames = config.benchmarkFrames;
+    maxSeconds = config.benchmarkSeconds;
+
+    framesSeen = 0;
+    samples.clear();
+    samples.reserve(maxFrames != 0 ? maxFrames : 4096);
+    gpuScopeNames.clear();
+    gpuSamples.clear();
+}
+
+/*
+* Registra un fotogramma. Il cronometro della durata parte dal primo
+* fotogramma dopo il riscaldamento.
+*/
+void BenchmarkRecorder::record(const FrameTimings& timings, const std::vector<GpuScopeTiming>& gpuTimings)
+{
+    framesSeen++;
+
+    if (framesSeen <= warmupFrames) {
+        return;
+    }
+
+    if (samples.empty()) {
+        start = std::chrono::steady_clock::now();
+    }
+
+    samples.push_back(timings);
+
+    // Ogni colonna GPU ha un valore per campione, NaN finché il blocco non viene letto.
+    for (std::vector<double>& column : gpuSamples) {
+        column.push_back(std::nan(""));
+    }
+
+    for (const GpuScopeTiming& scope : gpuTimings) {
+        auto it = std::find(gpuScopeNames.begin(), gpuScopeNames.end(), scope.name);
+        size_t index = size_t(it - gpuScopeNames.begin());
+
+        if (it == gpuScopeNames.end()) {
+            gpuScopeNames.push_back(scope.name);
+            gpuSamples.emplace_back(samples.size(), std::nan(""));
+        }
+
+        gpuSamples[index].back() = scope.ms;
+    }
+}
+
+bool BenchmarkRecorder::finished() const
+{
+    if (samples.empty()) {
+        return false;
+    }
+
+    if (maxFrames != 0 && samples.size() >= maxFrames) {
+        return true;
+    }
+
+    if (maxSeconds > 0.0) {
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        return elapsed.count() >= maxSeconds;
+    }
+
+    return false;
+}
+
+/*
+* Calcola i percentili con il metodo "nearest rank" sui valori ordinati.
+* Il vettore viene passato per copia, poiché va ordinato. I NaN vengono scartati.
+*/
+BenchmarkRecorder::Summary BenchmarkRecorder::summarize(std::vector<double> values)
+{
+    Summary summary{};
+
+    values.erase(std::remove_if(values.begin(), values.end(), [](double v) { return std::isnan(v); }), values.end());
+
+    if (values.empty()) {
+        return summary;
+    }
+
+    std::sort(values.begin(), values.end());
+
+    auto percentile = [&values](double p) {
+        size_t rank = size_t(std::ceil(p / 100.0 * values.size()));
+        return values[std::clamp<size_t>(rank, 1, values.size()) - 1];
+    };
+
+    summary.p50 = percentile(50.0);
+    summary.p95 = percentile(95.0);
+    summary.p99 = percentile(99.0);
+    summary.mean = std::accumulate(values.begin(), values.end(), 0.0) / values.size();
+    summary.min = values.front();
+    summary.max = values.back();
+
+    return summary;
+}
+
+/*
+* Raccoglie tutte le colonne del resoconto: prima i tempi della CPU,
+* poi un blocco GPU per colonna.
+*/
+std::vector<BenchmarkRecorder::Column> BenchmarkRecorder::columns() const
+{
+    std::vector<Column> result;
+
+    for (const TimingColumn& timing : timingColumns) {
+        Column column{ timing.name, {} };
+        column.values.reserve(samples.size());
+
+        for (const FrameTimings& sample : samples) {
+            column.values.push_back(sample.*timing.field);
+        }
+
+        result.push_back(std::move(column));
+    }
+
+    for (size_t i = 0; i < gpuScopeNames.size(); i++) {
+        result.push_back({ "gpu_" + gpuScopeNames[i] + "_ms", gpuSamples[i] });
+    }
+
+    return result;
+}
+
+void BenchmarkRecorder::print_summary() const
+{
+    fmt::print("Benchmark: {} fotogrammi misurati ({} di riscaldamento)\n", samples.size(), warmupFrames);
+
+    for (const Column& column : columns()) {
+        Summary s = summarize(column.values);
+        fmt::print("  {:<24} p50 {:8.3f}  p95 {:8.3f}  p99 {:8.3f}  media {:8.3f}\n",
+                   column.name, s.p50, s.p95, s.p99, s.mean);
+    }
+}
+
+/*
+* Scrive il resoconto, il formato viene scelto dall'estensione del file:
+* .json per JSON, qualsiasi altra per CSV.
+*/
+bool BenchmarkRecorder::write_report(const std::string& path) const
+{
+    bool json = path.size() >= 5 && path.compare(path.size() - 5, 5, ".json") == 0;
+
+    bool written = json ? write_json(path) : write_csv(path);
+
+    if (!written) {
+        fmt::print("Impossibile scrivere il resoconto del benchmark: {}\n", path);
+    }
+    else {
+        fmt::print("Resoconto del benchmark scritto in: {}\n", path);
+    }
+
+    return written;
+}
+
+/*
+* Il CSV contiene due tabelle separate da una riga vuota:
+* prima il riepilogo con una riga per metrica, poi i campioni grezzi.
+* I valori mancanti (NaN) vengono lasciati vuoti.
+*/
+bool BenchmarkRecorder::write_csv(const std::string& path) const
+{
+    std::ofstream file(path);
+
+    if (!file.is_open()) {
+        return false;
+    }
+
+    std::vector<Column> table = columns();
+
+    file << "metric,p50,p95,p99,mean,min,max\n";
+
+    for (const Column& column : table) {
+        Summary s = summarize(column.values);
+        file << fmt::format("{},{:.4f},{:.4f},{:.4f},{:.4f},{:.4f},{:.4f}\n",
+                            column.name, s.p50, s.p95, s.p99, s.mean, s.min, s.max);
+    }
+
+    file << "\nframe";
+    for (const Column& column : table) {
+        file << "," << column.name;
+    }
+    file << "\n";
+
+    for (size_t i = 0; i < samples.size(); i++) {
+        file << i;
+        for (const Column& column : table) {
+            double value = column.values[i];
+            file << (std::isnan(value) ? std::string(",") : fmt::format(",{:.4f}", value));
+        }
+        file << "\n";
+    }
+
+    return file.good();
+}
+
+/*
+* Nel JSON i valori mancanti diventano null, poiché NaN non è un valore JSON valido.
+*/
+bool BenchmarkRecorder::write_json(const std::string& path) const
+{
+    std::ofstream file(path);
+
+    if (!file.is_open()) {
+        return false;
+    }
+
+    std::vector<Column> table = columns();
+
+    file << "{\n  \"warmup_frames\": " << warmupFrames << ",\n";
+    file << "  \"frames\": " << samples.size() << ",\n";
+    file << "  \"summary\": {\n";
+
+    for (size_t c = 0; c < table.size(); c++) {
+        Summary s = summarize(table[c].values);
+
+        file << fmt::format("    \"{}\": {{ \"p50\": {:.4f}, \"p95\": {:.4f}, \"p99\": {:.4f}, "
+                            "\"mean\": {:.4f}, \"min\": {:.4f}, \"max\": {:.4f} }}{}\n",
+                            table[c].name, s.p50, s.p95, s.p99, s.mean, s.min, s.max,
+                            c + 1 < table.size() ? "," : "");
+    }
+
+    file << "  },\n  \"samples\": {\n";
+
+    for (size_t c = 0; c < table.size(); c++) {
+        file << "    \"" << table[c].name << "\": [";
+        for (size_t i = 0; i < table[c].values.size(); i++) {
+            double value = table[c].values[i];
+            file << (i == 0 ? "" : ", ") << (std::isnan(value) ? std::string("null") : fmt::format("{:.4f}", value));
+        }
+        file << "]" << (c + 1 < table.size() ? "," : "") << "\n";
+    }
+
+    file << "  }\n}\n";
+
+    return file.good();
+}
@@ -0,0 +1,235 @@
+#include "../include/vk_bindless.hpp"
+#include "../include/vk_descriptors.hpp"
+#include "../include/vk_init.hpp"
+#include <algorithm>
+#include <fmt/core.h>
+
+uint32_t FreeListAllocator::allocate()
+{
+	if (!freeIndices.empty()) {
+		uint32_t index = freeIndices.back();
+		freeIndices.pop_back();
+		return index;
+	}
+
+	if (next >= capacity) {
+		return invalidIndex;
+	}
+
+	return next++;
+}
+
+void FreeListAllocator::release(uint32_t index)
+{
+	if (index != invalidIndex) {
+		freeIndices.push_back(index);
+	}
+}
+
+/*
+* Riduce le dimensioni richieste ai limiti del dispositivo per i descrittori UPDATE_AFTER_BIND.
+*
+* Ogni array deve stare nel limite per stage e in quello per set del suo tipo; le immagini
+* campionate (COMBINED_IMAGE_SAMPLER) contano sia come sampler che come sampled image.
+* Se la somma supera maxPerStageUpdateAfterBindResources, riduciamo tutti gli array in proporzione.
+*/
+static void clamp_to_device_limits(VkPhysicalDevice physicalDevice, uint32_t& storageImages,
+								   uint32_t& sampledImages, uint32_t& storageBuffers)
+{
+	VkPhysicalDeviceDescriptorIndexingProperties indexing = {};
+	indexing.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_PROPERTIES;
+	indexing.pNext = nullptr;
+
+	VkPhysicalDeviceProperties2 properties = {};
+	properties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2;
+	properties.pNext = &indexing;
+
+	vkGetPhysicalDeviceProperties2(physicalDevice, &properties);
+
+	storageImages = std::min({ storageImages,
+							   indexing.maxPerStageDescriptorUpdateAfterBindStorageImages,
+							   indexing.maxDescriptorSetUpdateAfterBindStorageImages });
+
+	sampledImages = std::min({ sampledImages,
+							   indexing.maxPerStageDescriptorUpdateAfterBindSampledImages,
+							   indexing.maxPerStageDescriptorUpdateAfterBindSamplers,
+							   indexing.maxDescriptorSetUpdateAfterBindSampledImages,
+							   indexing.maxDescriptorSetUpdateAfterBindSamplers });
+
+	storageBuffers = std::min({ storageBuffers,
+								indexing.maxPerStageDescriptorUpdateAfterBindStorageBuffers,
+								indexing.maxDescriptorSetUpdateAfterBindStorageBuffers });
+
+	uint64_t total = uint64_t(storageImages) + sampledImages + storageBuffers;
+	uint64_t limit = indexing.maxPerStageUpdateAfterBindResources;
+
+	if (total > limit) {
+		storageImages = uint32_t(storageImages * limit / total);
+		sampledImages = uint32_t(sampledImages * limit / total);
+		storageBuffers = uint32_t(storageBuffers * limit / total);
+	}
+}
+
+/*
+* Il layout e la pool vanno creati con il flag UPDATE_AFTER_BIND_POOL,
+* e i flag di ogni binding passano tramite VkDescriptorSetLayoutBindingFlagsCreateInfo.
+*/
+void BindlessHeap::init(VkDevice device, VkPhysicalDevice physicalDevice, VkShaderStageFlags stages)
+{
+	uint32_t storageImageCount = maxStorageImages;
+	uint32_t sampledImageCount = maxSampledImages;
+	uint32_t storageBufferCount = maxStorageBuffers;
+
+	clamp_to_device_limits(physicalDevice, storageImageCount, sampledImageCount, storageBufferCount);
+
+	fmt::print("Tabella bindless: {} storage image, {} immagini campionate, {} storage buffer\n",
+			   storageImageCount, sampledImageCount, storageBufferCount);
+
+	DescriptorLayoutBuilder builder;
+	builder.add_binding(storageImageBinding, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, storageImageCount);
+	builder.add_binding(sampledImageBinding, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, sampledImageCount);
+	builder.add_binding(storageBufferBinding, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, storageBufferCount);
+
+	VkDescriptorBindingFlags bindingFlags[3];
+	for (VkDescriptorBindingFlags& flags : bindingFlags) {
+		flags = VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT | VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT |
+				VK_DESCRIPTOR_BINDING_UPDATE_UNUSED_WHILE_PENDING_BIT;
+	}
+
+	VkDescriptorSetLayoutBindingFlagsCreateInfo bindingFlagsInfo = {};
+	bindingFlagsInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO;
+	bindingFlagsInfo.pNext = nullptr;
+	bindingFlagsInfo.bindingCount = 3;
+	bindingFlagsInfo.pBindingFlags = bindingFlags;
+
+	layout = builder.build(device, stages, &bindingFlagsInfo, VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT);
+
+	VkDescriptorPoolSize poolSizes[3] = {
+		{ VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, storageImageCount },
+		{ VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, sampledImageCount },
+		{ VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, storageBufferCount },
+	};
+
+	VkDescriptorPoolCreateInfo poolInfo = { .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO };
+	poolInfo.pNext = nullptr;
+	poolInfo.flags = VK_DESCRIPTOR_POOL_CREATE_UPDATE_AFTER_BIND_BIT;
+	poolInfo.maxSets = 1;
+	poolInfo.poolSizeCount = 3;
+	poolInfo.pPoolSizes = poolSizes;
+
+	vkInit::VK_CHECK(vkCreateDescriptorPool(device, &poolInfo, nullptr, &pool));
+
+	VkDescriptorSetAllocateInfo allocInfo = { .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO };
+	allocInfo.pNext = nullptr;
+	allocInfo.descriptorPool = pool;
+	allocInfo.descriptorSetCount = 1;
+	allocInfo.pSetLayouts = &layout;
+
+	vkInit::VK_CHECK(vkAllocateDescriptorSets(device, &allocInfo, &set));
+
+	storageImages = { storageImageCount };
+	sampledImages = { sampledImageCount };
+	storageBuffers = { storageBufferCount };
+}
+
+void BindlessHeap::destroy(VkDevice device)
+{
+	vkDestroyDescriptorPool(device, pool, nullptr);
+	vkDestroyDescriptorSetLayout(device, layout, nullptr);
+}
+
+/*
+* Ogni registrazione prende un indice libero dal suo array e ci scrive il descrittore.
+* Con la tabella piena non scriviamo nulla e ritorniamo invalidIndex: decide il chiamante
+* se rinunciare alla risorsa o liberare qualche elemento e riprovare.
+*/
+static uint32_t allocate_index(FreeListAllocator& allocator, const char* kind)
+{
+	uint32_t index = allocator.allocate();
+
+	if (index == FreeListAllocator::invalidIndex) {
+		fmt::print("Tabella bindless piena: {} ({} elementi)\n", kind, allocator.capacity);
+	}
+
+	return index;
+}
+
+uint32_t BindlessHeap::register_storage_image(VkDevice device, VkImageView view, VkImageLayout imageLayout)
+{
+	uint32_t index = allocate_index(storageImages, "storage image");
+
+	if (index == FreeListAllocator::invalidIndex) {
+		return index;
+	}
+
+	VkDescriptorImageInfo imageInfo = {};
+	imageInfo.imageView = view;
+	imageInfo.imageLayout = imageLayout;
+
+	VkWriteDescriptorSet write = { .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET };
+	write.pNext = nullptr;
+	write.dstSet = set;
+	write.dstBinding = storageImageBinding;
+	write.dstArrayElement = index;
+	write.descriptorCount = 1;
+	write.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+	write.pImageInfo = &imageInfo;
+
+	vkUpdateDescriptorSets(device, 1, &write, 0, nullptr);
+
+	return index;
+}
+
+uint32_t BindlessHeap::register_sampled_image(VkDevice device, VkImageView view, VkSampler sampler, VkImageLayout imageLayout)
+{
+	uint32_t index = allocate_index(sampledImages, "immagini campionate");
+
+	if (index == FreeListAllocator::invalidIndex) {
+		return index;
+	}
+
+	VkDescriptorImageInfo imageInfo = {};
+	imageInfo.sampler = sampler;
+	imageInfo.imageView = view;
+	imageInfo.imageLayout = imageLayout;
+
+	VkWriteDescriptorSet write = { .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET };
+	write.pNext = nullptr;
+	write.dstSet = set;
+	write.dstBinding = sampledImageBinding;
+	write.dstArrayElement = index;
+	write.descriptorCount = 1;
+	write.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+	write.pImageInfo = &imageInfo;
+
+	vkUpdateDescriptorSets(device, 1, &write, 0, nullptr);
+
+	return index;
+}
+
+uint32_t BindlessHeap::register_storage_buffer(VkDevice device, VkBuffer buffer, VkDeviceSize offset, VkDeviceSize range)
+{
+	uint32_t index = allocate_index(storageBuffers, "storage buffer");
+
+	if (index == FreeListAllocator::invalidIndex) {
+		return index;
+	}
+
+	VkDescriptorBufferInfo bufferInfo = {};
+	bufferInfo.buffer = buffer;
+	bufferInfo.offset = offset;
+	bufferInfo.range = range;
+
+	VkWriteDescriptorSet write = { .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET };
+	write.pNext = nullptr;
+	write.dstSet = set;
+	write.dstBinding = storageBufferBinding;
+	write.dstArrayElement = index;
+	write.descriptorCount = 1;
+	write.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+	write.pBufferInfo = &bufferInfo;
+
+	vkUpdateDescriptorSets(device, 1, &write, 0, nullptr);
+
+	return index;
+}
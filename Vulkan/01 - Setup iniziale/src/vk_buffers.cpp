@@ -0,0 +1,47 @@
+#include "../include/vk_buffers.hpp"
+#include "../include/vk_init.hpp"
+
+/*
+* Funzione che crea un buffer.
+*
+* Il tipo di memoria viene scelto dal VMA in base a memoryUsage, mentre con i flags
+* possiamo chiedere, ad esempio, che il buffer resti mappato per tutta la sua vita
+* (VMA_ALLOCATION_CREATE_MAPPED_BIT), cosi da scriverci o leggerci dalla CPU
+* senza chiamare vmaMapMemory ogni volta.
+*/
+AllocatedBuffer vkutil::create_buffer(VmaAllocator allocator, size_t allocSize, VkBufferUsageFlags usage,
+									  VmaMemoryUsage memoryUsage, VmaAllocationCreateFlags flags)
+{
+	VkBufferCreateInfo bufferInfo = { .sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO };
+	bufferInfo.pNext = nullptr;
+	bufferInfo.size = allocSize;
+	bufferInfo.usage = usage;
+
+	VmaAllocationCreateInfo vmaallocInfo = {};
+	vmaallocInfo.usage = memoryUsage;
+	vmaallocInfo.flags = flags;
+
+	AllocatedBuffer newBuffer{};
+
+	vkInit::VK_CHECK(vmaCreateBuffer(allocator, &bufferInfo, &vmaallocInfo, &newBuffer.buffer,
+									 &newBuffer.allocation, &newBuffer.info));
+
+	// L'allocatore è creato con BUFFER_DEVICE_ADDRESS, basta chiedere l'indirizzo al dispositivo.
+	if (usage & VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT) {
+		VmaAllocatorInfo allocatorInfo;
+		vmaGetAllocatorInfo(allocator, &allocatorInfo);
+
+		VkBufferDeviceAddressInfo addressInfo = { .sType = VK_STRUCTURE_TYPE_BUFFER_DEVICE_ADDRESS_INFO };
+		addressInfo.pNext = nullptr;
+		addressInfo.buffer = newBuffer.buffer;
+
+		newBuffer.address = vkGetBufferDeviceAddress(allocatorInfo.device, &addressInfo);
+	}
+
+	return newBuffer;
+}
+
+void vkutil::destroy_buffer(VmaAllocator allocator, const AllocatedBuffer& buffer)
+{
+	vmaDestroyBuffer(allocator, buffer.buffer, buffer.allocation);
+}
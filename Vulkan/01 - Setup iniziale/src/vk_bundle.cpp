@@ -0,0 +1,121 @@
+#include "../include/vk_bundle.hpp"
+#include <cstring>
+#include <filesystem>
+#include <fmt/core.h>
+
+/*
+* Apre l'archivio e ne valida l'indice. Se qualcosa non torna l'archivio
+* viene chiuso e ritorniamo false, l'engine leggerà i singoli file .spv.
+*/
+bool ShaderBundle::open(const std::string& bundlePath)
+{
+	path = bundlePath;
+
+	if (!file.open(bundlePath)) {
+		return false;
+	}
+
+	ShaderBundleHeader header;
+
+	if (file.size < sizeof(header)) {
+		fmt::print("Archivio delle shader troppo piccolo: {}\n", bundlePath);
+		close();
+		return false;
+	}
+
+	std::memcpy(&header, file.data, sizeof(header));
+
+	if (header.magic != ShaderBundleHeader::magicValue || header.version != ShaderBundleHeader::currentVersion) {
+		fmt::print("Archivio delle shader non valido o di un'altra versione: {}\n", bundlePath);
+		close();
+		return false;
+	}
+
+	uint64_t indexEnd = sizeof(header) + uint64_t(header.entryCount) * sizeof(ShaderBundleEntry) + header.namesSize;
+
+	if (indexEnd > file.size) {
+		fmt::print("Indice dell'archivio delle shader troncato: {}\n", bundlePath);
+		close();
+		return false;
+	}
+
+	for (uint32_t i = 0; i < header.entryCount; i++) {
+		ShaderBundleEntry entry;
+		std::memcpy(&entry, file.data + sizeof(header) + i * sizeof(ShaderBundleEntry), sizeof(entry));
+
+		bool validName = uint64_t(entry.nameOffset) + entry.nameSize <= header.namesSize;
+		bool validBlob = entry.offset >= indexEnd && entry.offset % alignof(uint32_t) == 0 &&
+						 entry.size % sizeof(uint32_t) == 0 && entry.offset + entry.size <= file.size;
+
+		if (!validName || !validBlob) {
+			fmt::print("Voce {} dell'archivio delle shader non valida: {}\n", i, bundlePath);
+			close();
+			return false;
+		}
+	}
+
+	return true;
+}
+
+void ShaderBundle::close()
+{
+	file.close();
+}
+
+/*
+* Confrontiamo solo le date di modifica, senza leggere i file: un .spv ricompilato dopo
+* l'ultima build non deve essere nascosto da un archivio vecchio.
+*/
+bool ShaderBundle::is_outdated(const std::string& shaderDir) const
+{
+	namespace fs = std::filesystem;
+
+	std::error_code error;
+	fs::file_time_type bundleTime = fs::last_write_time(path, error);
+
+	if (error) {
+		return true;
+	}
+
+	for (const auto& entry : fs::directory_iterator(shaderDir, error)) {
+		if (entry.path().extension() == ".spv" && entry.last_write_time(error) > bundleTime) {
+			return true;
+		}
+	}
+
+	return false;
+}
+
+uint32_t ShaderBundle::count() const
+{
+	if (file.data == nullptr) {
+		return 0;
+	}
+
+	ShaderBundleHeader header;
+	std::memcpy(&header, file.data, sizeof(header));
+
+	return header.entryCount;
+}
+
+/*
+* Gli indici sono già stati controllati in open(), qui leggiamo solo i valori.
+*/
+BundledShader ShaderBundle::shader(uint32_t index) const
+{
+	ShaderBundleHeader header;
+	std::memcpy(&header, file.data, sizeof(header));
+
+	ShaderBundleEntry entry;
+	std::memcpy(&entry, file.data + sizeof(header) + index * sizeof(ShaderBundleEntry), sizeof(entry));
+
+	const std::byte* names = file.data + sizeof(header) + header.entryCount * sizeof(ShaderBundleEntry);
+
+	BundledShader shader;
+	shader.name = std::string_view(reinterpret_cast<const char*>(names + entry.nameOffset), entry.nameSize);
+	shader.code = std::span<const uint32_t>(reinterpret_cast<const uint32_t*>(file.data + entry.offset),
+											entry.size / sizeof(uint32_t));
+	shader.hash = entry.hash;
+
+	return shader;
+}
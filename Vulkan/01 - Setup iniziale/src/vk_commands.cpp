@@ -0,0 +1,52 @@
+#include "../include/vk_commands.hpp"
+#include "../include/vk_init.hpp"
+
+void ThreadCommandPool::init(VkDevice device, uint32_t queueFamily)
+{
+	VkCommandPoolCreateInfo poolInfo = vkInit::command_pool_create_info(queueFamily, 0);
+	vkInit::VK_CHECK(vkCreateCommandPool(device, &poolInfo, nullptr, &pool));
+
+	secondaries.clear();
+	used = 0;
+}
+
+/*
+* Distruggere la pool libera anche tutti i command buffer allocati da essa.
+*/
+void ThreadCommandPool::destroy(VkDevice device)
+{
+	vkDestroyCommandPool(device, pool, nullptr);
+	secondaries.clear();
+	used = 0;
+}
+
+void ThreadCommandPool::reset(VkDevice device)
+{
+	vkInit::VK_CHECK(vkResetCommandPool(device, pool, 0));
+	used = 0;
+}
+
+/*
+* Il secondario viene eseguito fuori da un render pass, quindi l'ereditarietà è vuota.
+* Per disegnare con il dynamic rendering andrebbe aggiunta VkCommandBufferInheritanceRenderingInfo.
+*/
+VkCommandBuffer ThreadCommandPool::begin_secondary(VkDevice device)
+{
+	if (used == secondaries.size()) {
+		VkCommandBufferAllocateInfo allocInfo = vkInit::command_buffer_allocate_info(pool, 1, VK_COMMAND_BUFFER_LEVEL_SECONDARY);
+
+		VkCommandBuffer cmd;
+		vkInit::VK_CHECK(vkAllocateCommandBuffers(device, &allocInfo, &cmd));
+		secondaries.push_back(cmd);
+	}
+
+	VkCommandBuffer cmd = secondaries[used++];
+
+	VkCommandBufferInheritanceInfo inheritance = vkInit::command_buffer_inheritance_info();
+	VkCommandBufferBeginInfo beginInfo = vkInit::commandBufferBeginInfo(VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT);
+	beginInfo.pInheritanceInfo = &inheritance;
+
+	vkInit::VK_CHECK(vkBeginCommandBuffer(cmd, &beginInfo));
+
+	return cmd;
+}
@@ -0,0 +1,206 @@
+#include "../include/vk_config.hpp"
+#include <fmt/core.h>
+#include <string_view>
+#include <cstdlib>
+#include <algorithm>
+
+/*
+* Funzione che legge gli argomenti della riga di comando.
+*
+* Le opzioni che richiedono un valore lo leggono dall'argomento successivo,
+* se manca, o se l'opzione non è riconosciuta, viene stampato l'uso del programma
+* e l'opzione viene ignorata.
+*/
+EngineConfig vkConfig::parse_args(int argc, char* argv[])
+{
+	EngineConfig config;
+	bool shaderDirGiven = false;
+	bool shaderBundleGiven = false;
+
+	for (int i = 1; i < argc; i++) {
+		std::string_view arg = argv[i];
+		const bool hasValue = i + 1 < argc;
+
+		if (arg == "--headless") {
+			config.headless = true;
+		}
+		else if (arg == "--width" && hasValue) {
+			config.width = uint32_t(std::strtoul(argv[++i], nullptr, 10));
+		}
+		else if (arg == "--height" && hasValue) {
+			config.height = uint32_t(std::strtoul(argv[++i], nullptr, 10));
+		}
+		else if (arg == "--frames" && hasValue) {
+			config.frameCount = uint32_t(std::strtoul(argv[++i], nullptr, 10));
+		}
+		else if (arg == "--dump" && hasValue) {
+			config.dumpPath = argv[++i];
+		}
+		else if (arg == "--benchmark-frames" && hasValue) {
+			config.benchmarkFrames = uint32_t(std::strtoul(argv[++i], nullptr, 10));
+		}
+		else if (arg == "--benchmark-seconds" && hasValue) {
+			config.benchmarkSeconds = std::strtod(argv[++i], nullptr);
+		}
+		else if (arg == "--warmup" && hasValue) {
+			config.warmupFrames = uint32_t(std::strtoul(argv[++i], nullptr, 10));
+		}
+		else if (arg == "--benchmark-out" && hasValue) {
+			config.benchmarkOutput = argv[++i];
+		}
+		else if (arg == "--gpu-log" && hasValue) {
+			config.gpuLogInterval = uint32_t(std::strtoul(argv[++i], nullptr, 10));
+		}
+		else if (arg == "--pipeline-cache" && hasValue) {
+			config.pipelineCachePath = argv[++i];
+		}
+		else if (arg == "--no-pipeline-cache") {
+			config.pipelineCachePath.clear();
+		}
+		else if (arg == "--threads" && hasValue) {
+			config.workerThreads = uint32_t(std::strtoul(argv[++i], nullptr, 10));
+		}
+		else if (arg == "--frames-in-flight" && hasValue) {
+			uint32_t frames = uint32_t(std::strtoul(argv[++i], nullptr, 10));
+			config.framesInFlight = std::clamp(frames, 1u, EngineConfig::maxFramesInFlight);
+		}
+		else if (arg == "--effect" && hasValue) {
+			config.backgroundEffect = argv[++i];
+		}
+		else if (arg == "--full-barriers") {
+			config.fullBarriers = true;
+		}
+		else if (arg == "--staging-mb" && hasValue) {
+			config.stagingMegabytes = std::max(1u, uint32_t(std::strtoul(argv[++i], nullptr, 10)));
+		}
+		else if (arg == "--memory-log" && hasValue) {
+			config.memoryLogInterval = uint32_t(std::strtoul(argv[++i], nullptr, 10));
+		}
+		else if (arg == "--memory-dump" && hasValue) {
+			config.memoryDumpPath = argv[++i];
+		}
+		else if (arg == "--no-memory-scaling") {
+			config.memoryScaling = false;
+		}
+		else if (arg == "--no-async-compute") {
+			config.asyncCompute = false;
+		}
+		else if (arg == "--parallel-recording") {
+			config.parallelRecording = true;
+		}
+		else if (arg == "--present" && hasValue) {
+			if (!parse_present_policy(argv[++i], config.presentPolicy)) {
+				fmt::print("Modalità di presentazione non valida: {}\n", argv[i]);
+				print_usage(argv[0]);
+			}
+		}
+		else if (arg == "--shaders" && hasValue) {
+			config.shaderDir = argv[++i];
+			shaderDirGiven = true;
+		}
+		else if (arg == "--shader-bundle" && hasValue) {
+			config.shaderBundle = argv[++i];
+			shaderBundleGiven = true;
+		}
+		else if (arg == "--no-shader-bundle") {
+			config.shaderBundle.clear();
+			shaderBundleGiven = true;
+		}
+		else if (arg == "--hot-reload") {
+			config.hotReload = true;
+		}
+		else {
+			fmt::print("Opzione non valida: {}\n", arg);
+			print_usage(argv[0]);
+		}
+	}
+
+	/*
+	* L'archivio predefinito contiene le shader della cartella del progetto: con un'altra
+	* cartella cerchiamo l'archivio al suo interno, cosi pipeline e hot-reload usano gli stessi file.
+	*/
+	if (shaderDirGiven && !shaderBundleGiven) {
+		config.shaderBundle = config.shaderDir + "/shaders.bundle";
+	}
+
+	// Il benchmark decide da solo quando fermarsi.
+	if (config.headless && config.frameCount == 0 && !config.benchmark()) {
+		config.frameCount = EngineConfig::defaultHeadlessFrames;
+	}
+
+	return config;
+}
+
+void vkConfig::print_usage(const char* program)
+{
+	fmt::print("Uso: {} [opzioni]\n"
+			   "  --headless          renderizza senza finestra e senza swapchain\n"
+			   "  --width <px>        larghezza dell'immagine\n"
+			   "  --height <px>       altezza dell'immagine\n"
+			   "  --frames <n>        esci dopo n fotogrammi (0 = infiniti)\n"
+			   "  --dump <file.ppm>   in headless, salva l'ultimo fotogramma\n"
+			   "  --benchmark-frames <n>     misura n fotogrammi ed esci\n"
+			   "  --benchmark-seconds <s>    misura per s secondi ed esci\n"
+			   "  --warmup <n>               fotogrammi di riscaldamento (predefinito 60)\n"
+			   "  --benchmark-out <file>     resoconto .csv o .json (predefinito benchmark.csv)\n"
+			   "  --gpu-log <n>              stampa i tempi GPU ogni n fotogrammi\n"
+			   "  --pipeline-cache <file>    file della cache delle pipeline (predefinito pipeline_cache.bin)\n"
+			   "  --no-pipeline-cache        non caricare né salvare la cache delle pipeline\n"
+			   "  --threads <n>              thread di lavoro (predefinito: core - 1)\n"
+			   "  --frames-in-flight <n>     fotogrammi in volo, da 1 a 4 (predefinito 2)\n"
+			   "  --effect <nome>            effetto di sfondo iniziale (predefinito gradient_pixels)\n"
+			   "  --full-barriers            barriere complete su tutta la pipeline (per confronto)\n"
+			   "  --parallel-recording       registra i passaggi in parallelo sui worker\n"
+			   "  --no-async-compute         calcola lo sfondo sulla queue grafica\n"
+			   "  --staging-mb <n>           dimensione dell'anello di staging in MB (predefinito 32)\n"
+			   "  --memory-log <n>           stampa budget e uso della memoria GPU ogni n fotogrammi\n"
+			   "  --memory-dump <file.json>  salva le statistiche di VMA alla chiusura\n"
+			   "  --no-memory-scaling        non ridurre la risoluzione quando la memoria GPU scarseggia\n"
+			   "  --present <modalità>       vsync (fifo), low-latency (mailbox), uncapped (immediate)\n"
+			   "                             o relaxed (fifo-relaxed), predefinito vsync\n"
+			   "  --shaders <cartella>       cartella dei file SPIR-V (predefinito shaders)\n"
+			   "  --shader-bundle <file>     archivio delle shader (predefinito quello della build)\n"
+			   "  --no-shader-bundle         leggi i singoli file .spv invece dell'archivio\n"
+			   "  --hot-reload               ricarica le shader .spv modificate senza riavviare\n",
+			   program);
+}
+
+/*
+* Accetta sia il nome della politica che quello della modalità Vulkan corrispondente.
+*/
+bool vkConfig::parse_present_policy(std::string_view name, PresentPolicy& out)
+{
+	if (name == "vsync" || name == "fifo") {
+		out = PresentPolicy::Vsync;
+	}
+	else if (name == "low-latency" || name == "mailbox") {
+		out = PresentPolicy::LowLatency;
+	}
+	else if (name == "uncapped" || name == "immediate") {
+		out = PresentPolicy::Uncapped;
+	}
+	else if (name == "relaxed" || name == "fifo-relaxed") {
+		out = PresentPolicy::Relaxed;
+	}
+	else {
+		return false;
+	}
+
+	return true;
+}
+
+const char* vkConfig::present_policy_name(PresentPolicy policy)
+{
+	switch (policy) {
+	case PresentPolicy::Vsync:
+		return "vsync";
+	case PresentPolicy::LowLatency:
+		return "low-latency";
+	case PresentPolicy::Uncapped:
+		return "uncapped";
+	case PresentPolicy::Relaxed:
+		return "relaxed";
+	}
+
+	return "vsync";
+}
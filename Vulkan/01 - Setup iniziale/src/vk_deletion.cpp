@@ -0,0 +1,132 @@
+#include "../include/vk_deletion.hpp"
+#include <fmt/core.h>
+
+void DeletionQueue::init(VkDevice device, VmaAllocator allocator)
+{
+	_device = device;
+	_allocator = allocator;
+
+	// Riserviamo subito abbastanza spazio per non allocare nei primi frame.
+	_records.reserve(256);
+	_callbacks.reserve(64);
+	_batches.reserve(8);
+}
+
+void DeletionQueue::push_callback(void (*function)(void* context, uint64_t value), void* context, uint64_t value)
+{
+	_callbacks.push_back({ function, context, value });
+}
+
+/*
+* Chiude il lotto aperto. Se è vuoto non serve un nuovo lotto.
+* I valori sono crescenti, quindi i lotti restano ordinati.
+*/
+void DeletionQueue::close_batch(uint64_t value)
+{
+	size_t recordStart = _batches.empty() ? 0 : _batches.back().recordEnd;
+	size_t callbackStart = _batches.empty() ? 0 : _batches.back().callbackEnd;
+
+	if (_records.size() == recordStart && _callbacks.size() == callbackStart) {
+		return;
+	}
+
+	_batches.push_back({ value, _records.size(), _callbacks.size() });
+}
+
+/*
+* Distrugge i lotti completati. I lotti sono in ordine di valore, quindi quelli
+* da distruggere sono sempre all'inizio dei vettori.
+*/
+void DeletionQueue::collect(uint64_t completedValue)
+{
+	size_t batchCount = 0;
+	while (batchCount < _batches.size() && _batches[batchCount].value <= completedValue) {
+		batchCount++;
+	}
+
+	if (batchCount == 0) {
+		return;
+	}
+
+	size_t recordCount = _batches[batchCount - 1].recordEnd;
+	size_t callbackCount = _batches[batchCount - 1].callbackEnd;
+
+	destroy(recordCount, callbackCount);
+
+	// gli indici dei lotti rimasti ora partono dall'inizio dei vettori.
+	_batches.erase(_batches.begin(), _batches.begin() + batchCount);
+	for (Batch& batch : _batches) {
+		batch.recordEnd -= recordCount;
+		batch.callbackEnd -= callbackCount;
+	}
+}
+
+void DeletionQueue::flush()
+{
+	destroy(_records.size(), _callbacks.size());
+	_batches.clear();
+}
+
+/*
+* Distrugge i primi recordCount record e le prime callbackCount callback.
+* erase() sposta i rimanenti senza ridurre la capacità dei vettori.
+*/
+void DeletionQueue::destroy(size_t recordCount, size_t callbackCount)
+{
+	for (size_t i = callbackCount; i-- > 0;) {
+		const DeletionCallback& callback = _callbacks[i];
+		callback.function(callback.context, callback.value);
+	}
+
+	for (size_t i = recordCount; i-- > 0;) {
+		const DeletionRecord& record = _records[i];
+
+		switch (record.type) {
+			case VK_OBJECT_TYPE_IMAGE:
+				vmaDestroyImage(_allocator, (VkImage)record.handle, record.allocation);
+				break;
+			case VK_OBJECT_TYPE_BUFFER:
+				vmaDestroyBuffer(_allocator, (VkBuffer)record.handle, record.allocation);
+				break;
+			case VK_OBJECT_TYPE_IMAGE_VIEW:
+				vkDestroyImageView(_device, (VkImageView)record.handle, nullptr);
+				break;
+			case VK_OBJECT_TYPE_SAMPLER:
+				vkDestroySampler(_device, (VkSampler)record.handle, nullptr);
+				break;
+			case VK_OBJECT_TYPE_PIPELINE:
+				vkDestroyPipeline(_device, (VkPipeline)record.handle, nullptr);
+				break;
+			case VK_OBJECT_TYPE_PIPELINE_LAYOUT:
+				vkDestroyPipelineLayout(_device, (VkPipelineLayout)record.handle, nullptr);
+				break;
+			case VK_OBJECT_TYPE_SHADER_MODULE:
+				vkDestroyShaderModule(_device, (VkShaderModule)record.handle, nullptr);
+				break;
+			case VK_OBJECT_TYPE_DESCRIPTOR_SET_LAYOUT:
+				vkDestroyDescriptorSetLayout(_device, (VkDescriptorSetLayout)record.handle, nullptr);
+				break;
+			case VK_OBJECT_TYPE_DESCRIPTOR_POOL:
+				vkDestroyDescriptorPool(_device, (VkDescriptorPool)record.handle, nullptr);
+				break;
+			case VK_OBJECT_TYPE_COMMAND_POOL:
+				vkDestroyCommandPool(_device, (VkCommandPool)record.handle, nullptr);
+				break;
+			case VK_OBJECT_TYPE_SEMAPHORE:
+				vkDestroySemaphore(_device, (VkSemaphore)record.handle, nullptr);
+				break;
+			case VK_OBJECT_TYPE_FENCE:
+				vkDestroyFence(_device, (VkFence)record.handle, nullptr);
+				break;
+			case VK_OBJECT_TYPE_SWAPCHAIN_KHR:
+				vkDestroySwapchainKHR(_device, (VkSwapchainKHR)record.handle, nullptr);
+				break;
+			default:
+				fmt::print("Tipo di oggetto {} non gestito dalla deletion queue\n", int(record.type));
+				break;
+		}
+	}
+
+	_callbacks.erase(_callbacks.begin(), _callbacks.begin() + callbackCount);
+	_records.erase(_records.begin(), _records.begin() + recordCount);
+}
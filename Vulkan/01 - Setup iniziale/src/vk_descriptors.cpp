@@ -1,124 +1,185 @@
-#include "../include/vk_descriptors.hpp"
-#include "../include/vk_init.hpp"
-
-/*
-* Crea un bind e aggiungilo al vettore dei bindings
-* Questo crea un VkDescriptorSetLayoutBinding, per ora 
-* sappiamo solo il tipo di layout e il tipo del descrittore.
-* 
-* In questo caso essendo il primo binding, l'indice di esso  0,
-* mentre nel nostro caso, il tipo  lo stesso usato dalla shader,
-* quindi VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, poich la shader scrive
-* un'immagine.
-* 
-* Se la shader cambia tipo di operazione, allora ne va applicato il flag corrispondente.
-*/
-void DescriptorLayoutBuilder::add_binding(uint32_t binding, VkDescriptorType type)
-{
-    VkDescriptorSetLayoutBinding newbind{};
-    newbind.binding = binding;
-    newbind.descriptorCount = 1;
-    newbind.descriptorType = type;
-
-    bindings.push_back(newbind);
-}
-
-/* Funzione che costruisce la disposizione del descriptor set.
-*  Effettuiamo un loop in tutte le risorse inserite all'interno del descriptor,
-*  per poi impostarne i flag degli stage.
-* 
-*  Per ogni binding in un descriptor set, i flag possono essere diversi in base al tipo di shader,
-*  se fragment, vertex ecc. Nel nostro caso, non supporteremo i flag per binding specifici
-*  ma li forzeremo per tutto il descriptor set.
-*/
-VkDescriptorSetLayout DescriptorLayoutBuilder::build(VkDevice device, VkShaderStageFlags shaderStages,
-                                                     void* pNext, VkDescriptorSetLayoutCreateFlags flags)
-{
-    for (auto& b : bindings) {
-        b.stageFlags |= shaderStages;
-    }
-
-    VkDescriptorSetLayoutCreateInfo info = { .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO };
-    info.pNext = pNext;
-
-    info.pBindings = bindings.data();
-    info.bindingCount = (uint32_t)bindings.size();
-    info.flags = flags;
-
-    VkDescriptorSetLayout set;
-    vkInit::VK_CHECK(vkCreateDescriptorSetLayout(device, &info, nullptr, &set));
-
-    return set;
-}
-
-
-// Reset dei bindings passati ad una shader.
-void DescriptorLayoutBuilder::clear()
-{
-    bindings.clear();
-}
-
-
-
-/*
-* Funzioni di creazione e distruzione delle descriptorPools.
-* 
-* la funzione clear effettua un reset, distruggendo i descrittori allocati nella
-* pool, ma non distrugge la pool stessa.
-* 
-* Per creare una pool utilizziamo il tipo PoolSizeRatio che contiene:
-* 
-* - Tipo del descrittore
-* 
-* - Rateo per moltiplicare il parametro maxSets.
-* 
-* Questo ci fa controllare la grandezza della pool in base a quanti tipi di bindings
-* quella pool possiede.
-*/
-void DescriptorAllocator::init_pool(VkDevice device, uint32_t maxSets, std::span<PoolSizeRatio> poolRatios)
-{
-    std::vector<VkDescriptorPoolSize> poolSizes;
-    for (PoolSizeRatio ratio : poolRatios) {
-        poolSizes.push_back(VkDescriptorPoolSize{
-            .type = ratio.type,
-            .descriptorCount = uint32_t(ratio.ratio * maxSets)
-            });
-    }
-
-    VkDescriptorPoolCreateInfo pool_info = { .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO };
-    pool_info.flags = 0;
-    pool_info.maxSets = maxSets;
-    pool_info.poolSizeCount = (uint32_t)poolSizes.size();
-    pool_info.pPoolSizes = poolSizes.data();
-
-    vkCreateDescriptorPool(device, &pool_info, nullptr, &pool);
-}
-
-void DescriptorAllocator::clear_descriptors(VkDevice device)
-{
-    vkResetDescriptorPool(device, pool, 0);
-}
-
-void DescriptorAllocator::destroy_pool(VkDevice device)
-{
-    vkDestroyDescriptorPool(device, pool, nullptr);
-}
-
-/*
-* Inizializza la struttura di allocazione di memoria del descriptor Set.
-* 
-*/
-VkDescriptorSet DescriptorAllocator::allocate(VkDevice device, VkDescriptorSetLayout layout)
-{
-    VkDescriptorSetAllocateInfo allocInfo = { .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO };
-    allocInfo.pNext = nullptr;
-    allocInfo.descriptorPool = pool;
-    allocInfo.descriptorSetCount = 1;
-    allocInfo.pSetLayouts = &layout;
-
-    VkDescriptorSet ds;
-    vkInit::VK_CHECK(vkAllocateDescriptorSets(device, &allocInfo, &ds));
-
-    return ds;
-}
-
+#include "../include/vk_descriptors.hpp"
+#include "../include/vk_init.hpp"
+#include <algorithm>
+
+/*
+* Crea un bind e aggiungilo al vettore dei bindings
+* Questo crea un VkDescriptorSetLayoutBinding, per ora 
+* sappiamo solo il tipo di layout e il tipo del descrittore.
+* 
+* In questo caso essendo il primo binding, l'indice di esso è 0,
+* mentre nel nostro caso, il tipo è lo stesso usato dalla shader,
+* quindi VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, poiché la shader scrive
+* un'immagine.
+* 
+* Se la shader cambia tipo di operazione, allora ne va applicato il flag corrispondente.
+*
+* count è il numero di descrittori del binding, maggiore di 1 per gli array (ad esempio bindless).
+*/
+void DescriptorLayoutBuilder::add_binding(uint32_t binding, VkDescriptorType type, uint32_t count)
+{
+    VkDescriptorSetLayoutBinding newbind{};
+    newbind.binding = binding;
+    newbind.descriptorCount = count;
+    newbind.descriptorType = type;
+
+    bindings.push_back(newbind);
+}
+
+/* Funzione che costruisce la disposizione del descriptor set.
+*  Effettuiamo un loop in tutte le risorse inserite all'interno del descriptor,
+*  per poi impostarne i flag degli stage.
+* 
+*  Per ogni binding in un descriptor set, i flag possono essere diversi in base al tipo di shader,
+*  se fragment, vertex ecc. Nel nostro caso, non supporteremo i flag per binding specifici
+*  ma li forzeremo per tutto il descriptor set.
+*/
+VkDescriptorSetLayout DescriptorLayoutBuilder::build(VkDevice device, VkShaderStageFlags shaderStages,
+                                                     void* pNext, VkDescriptorSetLayoutCreateFlags flags)
+{
+    for (auto& b : bindings) {
+        b.stageFlags |= shaderStages;
+    }
+
+    VkDescriptorSetLayoutCreateInfo info = { .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO };
+    info.pNext = pNext;
+
+    info.pBindings = bindings.data();
+    info.bindingCount = (uint32_t)bindings.size();
+    info.flags = flags;
+
+    VkDescriptorSetLayout set;
+    vkInit::VK_CHECK(vkCreateDescriptorSetLayout(device, &info, nullptr, &set));
+
+    return set;
+}
+
+
+// Reset dei bindings passati ad una shader.
+void DescriptorLayoutBuilder::clear()
+{
+    bindings.clear();
+}
+
+
+
+/*
+* Funzioni dell'allocatore che cresce.
+*
+* La prima pool ha initialSets descriptorSet, le successive crescono
+* di una volta e mezza, cosi le pool create restano poche.
+*
+* Ogni PoolSizeRatio contiene il tipo del descrittore e il rateo per cui moltiplicare
+* il numero di set della pool: cosi la grandezza della pool segue i tipi di bindings che conterrà.
+*/
+void DescriptorAllocatorGrowable::init(VkDevice device, uint32_t initialSets, std::span<PoolSizeRatio> poolRatios)
+{
+    ratios.assign(poolRatios.begin(), poolRatios.end());
+    fullPools.clear();
+    readyPools.clear();
+
+    readyPools.push_back(create_pool(device, initialSets));
+
+    setsPerPool = std::min(uint32_t(initialSets * 1.5), maxSetsPerPool);
+}
+
+// Resetta tutte le pool: i descriptorSet allocati non sono più validi.
+void DescriptorAllocatorGrowable::clear_pools(VkDevice device)
+{
+    for (VkDescriptorPool pool : readyPools) {
+        vkResetDescriptorPool(device, pool, 0);
+    }
+    for (VkDescriptorPool pool : fullPools) {
+        vkResetDescriptorPool(device, pool, 0);
+        readyPools.push_back(pool);
+    }
+    fullPools.clear();
+}
+
+void DescriptorAllocatorGrowable::destroy_pools(VkDevice device)
+{
+    for (VkDescriptorPool pool : readyPools) {
+        vkDestroyDescriptorPool(device, pool, nullptr);
+    }
+    for (VkDescriptorPool pool : fullPools) {
+        vkDestroyDescriptorPool(device, pool, nullptr);
+    }
+    readyPools.clear();
+    fullPools.clear();
+}
+
+/*
+* Prende una pool pronta, o ne crea una nuova se non ce ne sono.
+* La pool viene tolta dalla lista, allocate() la rimette tra le pronte o tra le piene.
+*/
+VkDescriptorPool DescriptorAllocatorGrowable::get_pool(VkDevice device)
+{
+    if (!readyPools.empty()) {
+        VkDescriptorPool pool = readyPools.back();
+        readyPools.pop_back();
+        return pool;
+    }
+
+    VkDescriptorPool pool = create_pool(device, setsPerPool);
+    setsPerPool = std::min(uint32_t(setsPerPool * 1.5), maxSetsPerPool);
+
+    return pool;
+}
+
+VkDescriptorPool DescriptorAllocatorGrowable::create_pool(VkDevice device, uint32_t setCount)
+{
+    std::vector<VkDescriptorPoolSize> poolSizes;
+    for (PoolSizeRatio ratio : ratios) {
+        poolSizes.push_back(VkDescriptorPoolSize{
+            .type = ratio.type,
+            .descriptorCount = uint32_t(ratio.ratio * setCount)
+            });
+    }
+
+    VkDescriptorPoolCreateInfo pool_info = { .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO };
+    pool_info.flags = 0;
+    pool_info.maxSets = setCount;
+    pool_info.poolSizeCount = (uint32_t)poolSizes.size();
+    pool_info.pPoolSizes = poolSizes.data();
+
+    VkDescriptorPool pool;
+    vkInit::VK_CHECK(vkCreateDescriptorPool(device, &pool_info, nullptr, &pool));
+
+    return pool;
+}
+
+/*
+* Alloca un descriptorSet, pNext permette di concatenare ad esempio
+* VkDescriptorSetVariableDescriptorCountAllocateInfo.
+*
+* Se la pool è esaurita o frammentata riproviamo una sola volta con una pool nuova:
+* se fallisce anche lì il layout chiede più descrittori di quanti ne abbia una pool intera.
+*/
+VkDescriptorSet DescriptorAllocatorGrowable::allocate(VkDevice device, VkDescriptorSetLayout layout, void* pNext)
+{
+    VkDescriptorPool pool = get_pool(device);
+
+    VkDescriptorSetAllocateInfo allocInfo = { .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO };
+    allocInfo.pNext = pNext;
+    allocInfo.descriptorPool = pool;
+    allocInfo.descriptorSetCount = 1;
+    allocInfo.pSetLayouts = &layout;
+
+    VkDescriptorSet ds;
+    VkResult result = vkAllocateDescriptorSets(device, &allocInfo, &ds);
+
+    if (result == VK_ERROR_OUT_OF_POOL_MEMORY || result == VK_ERROR_FRAGMENTED_POOL) {
+        fullPools.push_back(pool);
+
+        pool = get_pool(device);
+        allocInfo.descriptorPool = pool;
+
+        result = vkAllocateDescriptorSets(device, &allocInfo, &ds);
+    }
+
+    vkInit::VK_CHECK(result);
+
+    readyPools.push_back(pool);
+
+    return ds;
+}
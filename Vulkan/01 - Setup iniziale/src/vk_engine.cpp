@@ -1,653 +1,1777 @@
-/**
- * @file vk_engine.cpp
- * @author Fabxx
- * @brief Classe che si occupa delle funzionalità di inizializzazione dell'engine.
- * @version 0.1
- * @date 2025-05-02
- * 
- * @copyright Copyright (c) 2025
- * 
- */
-
-#include <SDL2/SDL.h>
-#include <SDL2/SDL_vulkan.h>
-#include <cstddef>
-#include <iostream>
-#include <chrono>
-#include <thread>
-#include <fmt/core.h>
-#include <fmt/format.h>
-#include <filesystem>
-
-#include "../include/vk_engine.hpp"
-#include "../include/vk_images.hpp"
-#include "VkBootstrap.h"
-#include "vk_mem_alloc.hpp"
-
-// La prima cosa da fare è creare una finestra con SDL e la sua superficie.
-void VulkanEngine::init() {
-
-	constexpr int width {1280};
-	constexpr int heigh {720};
-
-    SDL_Init(SDL_INIT_VIDEO);
-    SDL_WindowFlags window_flags = (SDL_WindowFlags)(SDL_WINDOW_VULKAN);
-
-    window = SDL_CreateWindow(
-		"Vulkan Engine",
-		SDL_WINDOWPOS_UNDEFINED,
-		SDL_WINDOWPOS_UNDEFINED,
-        width,
-        heigh,
-		window_flags
-	);
-
-    init_vulkan();
-	init_swapchain();
-	init_commands();
-	init_sync_structures();
-	init_descriptors();
-	init_pipelines();
-
-    bIsInitialized = true;
-}
-
-
-// Creiamo l'istanza per la GPU con vk-bootstrap con debug di base.
-void VulkanEngine::init_vulkan() {
-
-    vkb::InstanceBuilder builder;
-    
-    auto returned_instance = builder.set_app_name("Nome applicazione")
-                    .request_validation_layers(true)
-                    .use_default_debug_messenger()
-                    .require_api_version(1, 3, 0)
-                    .build();
-    
-    vkb::Instance vkb_instance = returned_instance.value();
-
-    // Esporta nella classe l'istanza raccolta dal bootstrap e il debugger.
-    _instance = vkb_instance.instance;
-    _debug_messenger = vkb_instance.debug_messenger;
-
-	// Crea la superficie da passare alla finestra.
-	SDL_Vulkan_CreateSurface(window, _instance, &_surface);
-
-
-    /* In questa sezione otteniamo le feature di vulkan 1.3 per il dynamic rendering
-       questo ci evita l'uso dei frame buffer e dei render pass dalle versioni 
-       precedenti di vulkan, inoltre possiamo usare sync2 per sincronizzare meglio
-       le risorse.
-    */
-    VkPhysicalDeviceVulkan13Features features{ .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_3_FEATURES };
-	features.dynamicRendering = true;
-	features.synchronization2 = true;
-
-    /* Qui prendiamo le feature di vulkan 1.2
-       nello specifico, per usare i puntatori alla GPU senza agganciare dei buffer,
-       e per avere textures non legate a nulla.
-    */ 
-    VkPhysicalDeviceVulkan12Features features12{ .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES };
-	features12.bufferDeviceAddress = true;
-	features12.descriptorIndexing = true;
-
-    
-    /* Seleziona una GPU con vk-bootstrap 
-       Vogliamo una GPU che possa scrivere nella superficie di SDL e che supporti 
-       vulkan 1.3 con le caratteristiche selezionate.
-	*/
-	
-    vkb::PhysicalDeviceSelector selector{vkb_instance};
-	
-    vkb::PhysicalDevice physicalDevice = selector
-		.set_minimum_version(1, 3)
-		.set_required_features_13(features)
-		.set_required_features_12(features12)
-		.set_surface(_surface)
-		.select()
-		.value();
-
-    // Creiamo il dispositivo finale.
-	vkb::DeviceBuilder deviceBuilder{ physicalDevice };
-
-	vkb::Device vkbDevice = deviceBuilder.build().value();
-
-	// Prendi il dispositivo usato dall'intera applicazione.
-	_device = vkbDevice.device;
-	_chosenGPU = physicalDevice.physical_device;
-
-	// Ottieni le queue e i loro tipi
-	_graphicsQueue = vkbDevice.get_queue(vkb::QueueType::graphics).value();
-	_graphicsQueueFamily = vkbDevice.get_queue_index(vkb::QueueType::graphics).value();
-
-	// inizializza il memory allocator
-	VmaAllocatorCreateInfo allocatorInfo = {};
-	allocatorInfo.physicalDevice = _chosenGPU;
-	allocatorInfo.device = _device;
-	allocatorInfo.instance = _instance;
-	allocatorInfo.flags = VMA_ALLOCATOR_CREATE_BUFFER_DEVICE_ADDRESS_BIT;
-	vmaCreateAllocator(&allocatorInfo, &_allocator);
-
-	_mainDeletionQueue.push_function([&]() {
-		vmaDestroyAllocator(_allocator); 
-		});
-}
-
-/*
-    Funzione che crea la swapchain, selezioniamo il formato di colore standard RGBA8, con profondità
-    di 8 bit per canale, rappresentando 256 combinazioni di colori possibili.
-
-    NOTA: La modalità FIFO (first in first out) di presentazione dei fotogrammi forza il VSync,
-          in modo che l'engine generi lo stesso numero dei fotogrammi supportati dal refresh rate del monitor.
-
-	NOTA: RGBA8 è un formato dei colori Little-Endian, se vuoi big-endian, usa BGRA8
-
-    Inoltre, stiamo inoltrando la risoluzione delle immagini alla swapchain, perché le immagini devono 
-    avere la stessa risoluzione della finestra. Attualmente è fissa, ma più in là vedremo come ricostruire
-    la chain man mano che ridimensioniamo la finestra.
-*/
-void VulkanEngine::create_swapchain(uint32_t width, uint32_t height)
-{
-	vkb::SwapchainBuilder swapchainBuilder{ _chosenGPU,_device,_surface };
-
-	_swapchainImageFormat = VK_FORMAT_R8G8B8A8_UNORM;
-
-	vkb::Swapchain vkbSwapchain = swapchainBuilder
-		//.use_default_format_selection() il formato delle immagini l'abbiamo selezionato, quindi questa funzione è commentata
-		.set_desired_format(VkSurfaceFormatKHR{ .format = _swapchainImageFormat, .colorSpace = VK_COLOR_SPACE_SRGB_NONLINEAR_KHR })
-		// Usa modalità di presentazione con VSync (FIFO_KHR)
-		.set_desired_present_mode(VK_PRESENT_MODE_FIFO_KHR)
-		.set_desired_extent(width, height)
-		.add_image_usage_flags(VK_IMAGE_USAGE_TRANSFER_DST_BIT)
-		.build()
-		.value();
-
-	_swapchainExtent = vkbSwapchain.extent;
-	//store swapchain and its related images
-	_swapchain = vkbSwapchain.swapchain;
-	_swapchainImages = vkbSwapchain.get_images().value();
-	_swapchainImageViews = vkbSwapchain.get_image_views().value();
-}
-
-/*
-  Funzione che distrugge la catena di immagini.
-*/
-void VulkanEngine::destroy_swapchain()
-{
-	vkDestroySwapchainKHR(_device, _swapchain, nullptr);
-
-	// distruggi le risorse della chain
-	for (size_t i = 0; i < _swapchainImageViews.size(); i++) {
-		vkDestroyImageView(_device, _swapchainImageViews[i], nullptr);
-	}
-}
-
-
-/*
-  Funzione che elimina tutte le risorse usate.
-
-  Per testare che i layers funzionino correttamente, prova a distruggere l'istanza prima di tutto.
-*/
-void VulkanEngine::cleanup()
-{
-	if (bIsInitialized) {
-		/*
-		* Abbiamo creato la command pool con i buffer, aspettiamo che la GPU finisca e poi distruggiamo anch'essa.
-		* Siccome è l'oggetto più recente, distruggiamo prima esso, poi la swapchain e la superficie.
-		*/ 
-		vkDeviceWaitIdle(_device);
-
-		for (int i = 0; i < FRAME_OVERLAP; i++) {
-			vkDestroyCommandPool(_device, _frames[i].commandPool, nullptr);
-			
-			//destroy sync objects
-			vkDestroyFence(_device, _frames[i]._renderFence, nullptr);
-			vkDestroySemaphore(_device, _frames[i]._renderSemaphore, nullptr);
-			vkDestroySemaphore(_device, _frames[i]._swapchainSemaphore, nullptr);
-			_frames[i]._deletionQueue.flush();
-		}
-
-		//flush the global deletion queue
-		_mainDeletionQueue.flush();
-
-		destroy_swapchain();
-		vkDestroySurfaceKHR(_instance, _surface, nullptr);
-		vkDestroyDevice(_device, nullptr);
-		
-		vkb::destroy_debug_utils_messenger(_instance, _debug_messenger);
-		vkDestroyInstance(_instance, nullptr);
-		SDL_DestroyWindow(window);
-	}
-}
-
-
-
-void VulkanEngine::init_swapchain() {
-    create_swapchain(_swapchainExtent.width, _swapchainExtent.height);
-	
-	//La dimensione del disegno dell'immagine combacia con la finestra
-	VkExtent3D drawImageExtent = {
-		_swapchainExtent.width,
-		_swapchainExtent.height,
-		1
-	};
-
-	//hardcode il formato di disegno a 16 bit float
-	_drawImage.imageFormat = VK_FORMAT_R16G16B16A16_SFLOAT;
-	_drawImage.imageExtent = drawImageExtent;
-
-	VkImageUsageFlags drawImageUsages{};
-	drawImageUsages |= VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
-	drawImageUsages |= VK_IMAGE_USAGE_TRANSFER_DST_BIT;
-	drawImageUsages |= VK_IMAGE_USAGE_STORAGE_BIT;
-	drawImageUsages |= VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
-
-	VkImageCreateInfo rimg_info = vkInit::image_create_info(_drawImage.imageFormat, drawImageUsages, drawImageExtent);
-
-	//Allochiamo l'immagine da disegnare dalla memoria locale della GPU.
-	VmaAllocationCreateInfo rimg_allocinfo = {};
-	rimg_allocinfo.usage = VMA_MEMORY_USAGE_GPU_ONLY;
-	rimg_allocinfo.requiredFlags = VkMemoryPropertyFlags(VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
-
-	//Alloca e crea l'immagine
-	vmaCreateImage(_allocator, &rimg_info, &rimg_allocinfo, &_drawImage.image, &_drawImage.allocation, nullptr);
-
-	//Costruisci un'anteprima per l'immagine da usare nel rendering.
-	VkImageViewCreateInfo rview_info = vkInit::imageview_create_info(_drawImage.imageFormat, _drawImage.image, 
-																	 VK_IMAGE_ASPECT_COLOR_BIT);
-
-	vkInit::VK_CHECK(vkCreateImageView(_device, &rview_info, nullptr, &_drawImage.imageView));
-
-	// Aggiungi alle queue da cancellare.
-	_mainDeletionQueue.push_function([=]() {
-		vkDestroyImageView(_device, _drawImage.imageView, nullptr);
-		vmaDestroyImage(_allocator, _drawImage.image, _drawImage.allocation);
-		});
-}
-
-/*
-* Crea una command pool per i comandi da inviare alla queue
-* vogliamo che la pool ci permetta il reset dei command buffer individuali
-* 
-* il for loop crea le command pool definite
-* 
-* Le due strutture info contengono le informazioni riguardo
-* la command pool e i command buffer.
-*/
-void VulkanEngine::init_commands() {
-
-	for (int i = 0; i < FRAME_OVERLAP; i++) {	
-		VkCommandPoolCreateInfo commandPoolInfo{};
-		commandPoolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
-		commandPoolInfo.pNext = nullptr;
-		commandPoolInfo.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
-		commandPoolInfo.queueFamilyIndex = _graphicsQueueFamily;
-
-		vkInit::VK_CHECK(vkCreateCommandPool(_device, &commandPoolInfo, nullptr, &_frames[i].commandPool));
-		
-		VkCommandBufferAllocateInfo commandBufferInfo = {};
-		commandBufferInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
-		commandBufferInfo.pNext = nullptr;
-		commandBufferInfo.commandPool = _frames[i].commandPool;
-		commandBufferInfo.commandBufferCount = 1;
-		commandBufferInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
-
-		vkInit::VK_CHECK(vkAllocateCommandBuffers(_device, &commandBufferInfo, &_frames[i].commandBuffer));
-	}
-}
-
-
-/*
-* Una volta creati i command pool e buffer per inviare i comandi alla
-* GPU, dobbiamo sincronizzare queste strutture tra GPU e CPU per tracciarne
-* lo stato di esecuzione.
-*/
-void VulkanEngine::init_sync_structures()
-{
-	VkFenceCreateInfo fenceInfo = vkInit::fenceInfo(VK_FENCE_CREATE_SIGNALED_BIT);
-	VkSemaphoreCreateInfo semaphoreInfo = vkInit::semaphoreInfo(NULL);
-
-	for (int i = 0; i < FRAME_OVERLAP; i++) {
-		vkInit::VK_CHECK(vkCreateFence(_device, &fenceInfo, nullptr, &_frames[i]._renderFence));
-		vkInit::VK_CHECK(vkCreateSemaphore(_device, &semaphoreInfo, nullptr, &_frames[i]._swapchainSemaphore));
-		vkInit::VK_CHECK(vkCreateSemaphore(_device, &semaphoreInfo, nullptr, &_frames[i]._renderSemaphore));
-	}
-}
-
-/*
-* Funzione per disegnare sullo schermo.
-* 
-* NOTA: L'ideale sarebbe fare tutto tramite shaders, e non fare 
-* computazioni tramite CPU. questo codice verrà rimosso più in la.
-* 
-* Attendi che la GPU abbia terminato il suo lavoro
-* per poi resettare la Fence per sincronizzare il nuovo stato
-* del command buffer tra GPU e CPU.
-* 
-* La fence va resettata ad ogni comando usato dal buffer.
-* 
-* L'ultimo parametro della funzione wait rappresenta 1 secondo in nanosecondi.
-* 
-* Se impostato a 0, puoi sapere se la GPU sta ancora eseguendo il comando o no.
-* 
-* Poi, richiediamo l'indice dell'immagine nella swapchain, se nessuna immagine è
-* disponibile, il thread verrà bloccato per 1 secondo per ottenere un'immagine disponibile.
-* 
-* 
-*/
-
-
-/*
-* Funzione di init dei descriptors.
-* 
-* Creiamo 10 descrittori nel set di tipo STORE_IMAGE per la compute
-* shader usata.
-* 
-* Il vettore crea una pool che contiene 10 set (puntatori) con ciascuna 1 immagine.
-* 
-* Poi, si imposta la disposizione (layout) in scrittura, con il flag STAGE_COMPUTE.
-* 
-* Nota che la pool non ha allocazione dinamica, se si usano più di 10 descrittori
-* il programma crasha. La pool verrà resa dinamica più avanti.
-* 
-* 
-* Poi allochiamo il set di descrittori per la nostra immagine da disegnare.
-* 
-* In questo caso la struttura di allocazione indica che il set di descrittori
-* 
-* è di tipo STORAGE_IMAGE con layout generico.
-* 
-* Infine puliamo l'allocatore dei descrittori e i layout usati per l'immagine.
-* 
-* Il set 0 punta al Binding 0 dove l'immagine 2D viene presa dalla shader.
-* 
-* 
-*/
-void VulkanEngine::init_descriptors()
-{
-	std::vector<DescriptorAllocator::PoolSizeRatio> sizes = {{ VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, 1 }};
-
-	globalDescriptorAllocator.init_pool(_device, 10, sizes);
-
-	{
-		DescriptorLayoutBuilder builder;
-		builder.add_binding(0, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE);
-		_drawImageDescriptorLayout = builder.build(_device, VK_SHADER_STAGE_COMPUTE_BIT);
-	}
-
-
-
-	_drawImageDescriptors = globalDescriptorAllocator.allocate(_device, _drawImageDescriptorLayout);
-
-	VkDescriptorImageInfo imgInfo{};
-	imgInfo.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
-	imgInfo.imageView = _drawImage.imageView;
-
-	VkWriteDescriptorSet drawImageWrite = {};
-	drawImageWrite.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-	drawImageWrite.pNext = nullptr;
-
-	drawImageWrite.dstBinding = 0;
-	drawImageWrite.dstSet = _drawImageDescriptors;
-	drawImageWrite.descriptorCount = 1;
-	drawImageWrite.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
-	drawImageWrite.pImageInfo = &imgInfo;
-
-	vkUpdateDescriptorSets(_device, 1, &drawImageWrite, 0, nullptr);
-
-	_mainDeletionQueue.push_function([&]() {
-		globalDescriptorAllocator.destroy_pool(_device);
-
-		vkDestroyDescriptorSetLayout(_device, _drawImageDescriptorLayout, nullptr);
-	});
-}
-
-/*
-* Funzione che inizializza le pipeline in background.
-* 
-* Per creare una pipeline è necessario avere un array di layout 
-  di DescriptorSets e altre configurazioni come Push-Constants.
-
-  In questo caso non ne abbiamo bisogno per questa shader.
-
-  Ora creiamo l'oggetto pipeline vero e proprio aggiungendo lo 
-  shader module e altre informazioni tramite VkComputePipelineCreateInfo,
-
-  Dipende  dalle strutture stageInfo che richiede che la shader sia compilata
-
-  e dalla computePipelineCreateInfo, che richiede i dati compilati della struttura
-  precedente.
-
-  Se la compilazione della shader fallisce, allora il programma crasha.
-
-  Nota che l'entry point della shader in questo caso è main, ma se vogliamo
-  più shader module con diversi entry point, possiamo cambiare il nome
-  della funzione nella shader per poi farne riferimento qui.
-
-  Infine come ogni oggetto, distruggiamo lo shader module creato,
-  il layout della pipeline e la pipeline stessa.
-* 
-*/
-
-void VulkanEngine::init_pipelines()
-{
-	init_background_pipelines();
-}
-
-/*
-* Funzione che inizializza una pipeline, in questo caso una compute
-* pipeline.
-* 
-* La funzione scansiona la directory delle shaders e cerca i file compilati in 
-* 
-* SPRI-V da GLSL, se trova una shader valida, la carica all'interno dello shaderModule.
-* 
-* Infine, i dati della shader vengono passati ai descriptor sets.
-*/
-void VulkanEngine::init_background_pipelines()
-{
-	VkPipelineLayoutCreateInfo computeLayout{};
-	computeLayout.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
-	computeLayout.pNext = nullptr;
-	computeLayout.pSetLayouts = &_drawImageDescriptorLayout;
-	computeLayout.setLayoutCount = 1;
-
-	vkInit::VK_CHECK(vkCreatePipelineLayout(_device, &computeLayout, nullptr, &_gradientPipelineLayout));
-
-
-	VkShaderModule computeDrawShader = VK_NULL_HANDLE;
-
-	namespace fs = std::filesystem;
-
-	const std::string shaderDir = "shaders";
-
-	for (const auto& entry : fs::directory_iterator(shaderDir)) {
-		if (entry.is_regular_file() && entry.path().extension() == ".spv") {
-			const std::string path = entry.path().string();
-
-			VkShaderModule shaderModule;
-
-			if (!vkInit::load_shader_module(path.c_str(), _device, &shaderModule)) {
-				fmt::print("Failed to load shader: {}\n", path);
-			}
-			else {
-				fmt::print("Loaded shader: {}\n", path);
-				computeDrawShader = shaderModule;
-			}
-		}
-	}
-
-	VkPipelineShaderStageCreateInfo stageinfo{};
-	stageinfo.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
-	stageinfo.pNext = nullptr;
-	stageinfo.stage = VK_SHADER_STAGE_COMPUTE_BIT;
-	stageinfo.module = computeDrawShader;
-	stageinfo.pName = "main";
-
-	VkComputePipelineCreateInfo computePipelineCreateInfo{};
-	computePipelineCreateInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
-	computePipelineCreateInfo.pNext = nullptr;
-	computePipelineCreateInfo.layout = _gradientPipelineLayout;
-	computePipelineCreateInfo.stage = stageinfo;
-
-	vkInit::VK_CHECK(vkCreateComputePipelines(_device, VK_NULL_HANDLE, 1, &computePipelineCreateInfo, 
-											  nullptr, &_gradientPipeline));
-
-	vkDestroyShaderModule(_device, computeDrawShader, nullptr);
-
-	_mainDeletionQueue.push_function([&]() {
-		vkDestroyPipelineLayout(_device, _gradientPipelineLayout, nullptr);
-		vkDestroyPipeline(_device, _gradientPipeline, nullptr);
-		});
-}
-
-
-void VulkanEngine::draw() {
-
-	vkInit::VK_CHECK(vkWaitForFences(_device, 1, &get_current_frame()._renderFence, true, 1000000000));
-	
-	get_current_frame()._deletionQueue.flush();
-
-	vkInit::VK_CHECK(vkResetFences(_device, 1, &get_current_frame()._renderFence));
-
-	uint32_t swapchainImageIndex;
-	vkInit::VK_CHECK(vkAcquireNextImageKHR(_device, _swapchain, 1000000000, get_current_frame()._swapchainSemaphore,
-		nullptr, &swapchainImageIndex));
-
-	// reset del command buffer dopo l'esecuzione.
-
-	vkInit::VK_CHECK(vkResetCommandBuffer(get_current_frame().commandBuffer, 0));
-
-	//inizia la registrazione del command buffer, lo useremo una sola volta, il flag indica questo a Vulkan.
-	VkCommandBufferBeginInfo commandBufferBeginInfo = vkInit::commandBufferBeginInfo(VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT);
-
-	_drawExtent.width = _drawImage.imageExtent.width;
-	_drawExtent.height = _drawImage.imageExtent.height;
-
-	vkInit::VK_CHECK(vkBeginCommandBuffer(get_current_frame().commandBuffer, &commandBufferBeginInfo));
-
-	/*
-	* Transita l'immagine da disegnare nel layout generale cosi da scriverci dentro
-	* Lo sovrascriviamo completamente cosi non ci importa di cosa c'era nel vecchio layout.
-	*/
-
-	vkutil::transition_image(get_current_frame().commandBuffer, _drawImage.image, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_GENERAL);
-
-
-	// La funzione principale che disegna sullo schermo. Qui possiamo inserire altre funzioni di disegno in sequenza.
-	draw_background(get_current_frame().commandBuffer);
-
-	//Transita l'immagine e la swapchain nei loro corretti layout.
-	vkutil::transition_image(get_current_frame().commandBuffer, _drawImage.image, VK_IMAGE_LAYOUT_GENERAL, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL);
-	vkutil::transition_image(get_current_frame().commandBuffer, _swapchainImages[swapchainImageIndex], VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
-
-	// esegui una copia dell'immagine disegnata nella swapchain
-	vkutil::copy_image_to_image(get_current_frame().commandBuffer, _drawImage.image, _swapchainImages[swapchainImageIndex], _drawExtent, _swapchainExtent);
-
-	// imposta il layout della swapchain in "presentazione" cosi da mostrare l'immagine.
-	vkutil::transition_image(get_current_frame().commandBuffer, _swapchainImages[swapchainImageIndex], VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_PRESENT_SRC_KHR);
-
-	//Finalizza il command buffer (non possiamo aggiungere comandi, ma possiamo eseguirlo)
-	vkInit::VK_CHECK(vkEndCommandBuffer(get_current_frame().commandBuffer));
-
-
-	/*
-	* Prepara l'invio alla queue
-	* vogliamo aspettare il segnale del _presentSemaphore in quanto indica quando la swapchain è pronta.
-	* invieremo il segnale al _renderSemaphore per indicare che il rendering è finito.
-	*/
-
-	VkCommandBufferSubmitInfo cmdinfo = vkInit::command_buffer_submit_info(get_current_frame().commandBuffer);
-
-	VkSemaphoreSubmitInfo waitInfo = vkInit::semaphore_submit_info(VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT_KHR,
-		get_current_frame()._swapchainSemaphore);
-	VkSemaphoreSubmitInfo signalInfo = vkInit::semaphore_submit_info(VK_PIPELINE_STAGE_2_ALL_GRAPHICS_BIT,
-		get_current_frame()._renderSemaphore);
-
-	VkSubmitInfo2 submit = vkInit::submit_info(&cmdinfo, &signalInfo, &waitInfo);
-
-	// Invia il command buffer alla queue e eseguilo.
-	// _renderFence ora bloccherà fin quando i comandi grafici non hanno terminato l'esecuzione.
-	vkInit::VK_CHECK(vkQueueSubmit2(_graphicsQueue, 1, &submit, get_current_frame()._renderFence));
-
-
-	/*
-	* Prepara la presentazione
-	* 
-	* questo mette l'immagine che abbiamo renderizzato in una finestra visibile.
-	* vogliamo aspettare il _renderSemaphore per questo.
-	* è necessario che i comandi di disegno abbiano finito di renderizzare l'immagine
-	* prima di mostrarla all'utente.
-	*/
-	VkPresentInfoKHR presentInfo = {};
-	presentInfo.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
-	presentInfo.pNext = nullptr;
-	presentInfo.pSwapchains = &_swapchain;
-	presentInfo.swapchainCount = 1;
-	presentInfo.pWaitSemaphores = &get_current_frame()._renderSemaphore;
-	presentInfo.waitSemaphoreCount = 1;
-	presentInfo.pImageIndices = &swapchainImageIndex;
-
-	vkInit::VK_CHECK(vkQueuePresentKHR(_graphicsQueue, &presentInfo));
-
-	//Incrementa il numero dei fotogrammi disegnati.
-	_frameNumber++;
-}
-
-/*
-* Funzione di disegno in background.
-* 
-* Richiama la compute shader impostata, 
-* dandogli un punto di aggancio alla nostra pipeline
-* 
-* poi dandogli i descriptor sets che abbiamo creato per quella shader
-* e immagine.
-* 
-* Infine, eseguiamo la pipeline con il comando dispatch. Il disegno viene
-* diviso di 16 su larghezza e 16 su altezza, poiché il gruppo di lavoro
-* è di 16x16 nella shader.
-* 
-*/
-void VulkanEngine::draw_background(VkCommandBuffer cmd)
-{
-	
-	vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, _gradientPipeline);
-
-	vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, _gradientPipelineLayout, 0, 1, 
-							&_drawImageDescriptors, 0, nullptr);
-
-	vkCmdDispatch(cmd, std::ceil(_drawExtent.width / 16.0), std::ceil(_drawExtent.height / 16.0), 1);
-
-}
-
-void VulkanEngine::run()
-{
-	SDL_Event e;
-	bool bQuit = false;
-
-	// main loop
-	while (!bQuit) {
-		while (SDL_PollEvent(&e) != 0) {
-			if (e.type == SDL_QUIT)
-				bQuit = true;
-
-			if (e.type == SDL_WINDOWEVENT) {
-				if (e.window.event == SDL_WINDOWEVENT_MINIMIZED) {
-					stop_rendering = true;
-				}
-				if (e.window.event == SDL_WINDOWEVENT_RESTORED) {
-					stop_rendering = false;
-				}
-			}
-		}
-
-		// Non renderizzare se la finestra è minimizzata.
-		if (stop_rendering) {
-			// Rallenta la velocità del thread.
-			std::this_thread::sleep_for(std::chrono::milliseconds(100));
-			continue;
-		}
-
-		draw();
-	}
-}
+/**
+ * @file vk_engine.cpp
+ * @author Fabxx
+ * @brief Classe che si occupa delle funzionalità di inizializzazione dell'engine.
+ * @version 0.1
+ * @date 2025-05-02
+ * 
+ * @copyright Copyright (c) 2025
+ * 
+ */
+
+#include <SDL2/SDL.h>
+#include <SDL2/SDL_vulkan.h>
+#include <cstddef>
+#include <iostream>
+#include <chrono>
+#include <thread>
+#include <fmt/core.h>
+#include <fmt/format.h>
+#include <filesystem>
+#include <algorithm>
+
+#include "../include/vk_engine.hpp"
+#include "../include/vk_images.hpp"
+#include "../include/vk_buffers.hpp"
+#include "VkBootstrap.h"
+#include "vk_mem_alloc.hpp"
+
+/*
+* La prima cosa da fare è creare una finestra con SDL e la sua superficie.
+*
+* In modalità headless la finestra non viene creata: non avremo né superficie
+* né swapchain, e i fotogrammi verranno copiati in target fuori schermo.
+*/
+void VulkanEngine::init(const EngineConfig& config) {
+
+	_config = config;
+	_windowExtent = { config.width, config.height };
+
+	if (!_config.headless) {
+		SDL_Init(SDL_INIT_VIDEO);
+		SDL_WindowFlags window_flags = (SDL_WindowFlags)(SDL_WINDOW_VULKAN | SDL_WINDOW_RESIZABLE);
+
+		window = SDL_CreateWindow(
+			"Vulkan Engine",
+			SDL_WINDOWPOS_UNDEFINED,
+			SDL_WINDOWPOS_UNDEFINED,
+			_windowExtent.width,
+			_windowExtent.height,
+			window_flags
+		);
+	}
+
+	_jobs.init(_config.workerThreads);
+	_engineStart = std::chrono::steady_clock::now();
+
+    init_vulkan();
+	init_swapchain();
+	init_commands();
+	init_sync_structures();
+	init_descriptors();
+	init_pipelines();
+
+    bIsInitialized = true;
+}
+
+
+// Creiamo l'istanza per la GPU con vk-bootstrap con debug di base.
+void VulkanEngine::init_vulkan() {
+
+    vkb::InstanceBuilder builder;
+    
+    // In headless non servono le estensioni della superficie, vk-bootstrap le omette.
+    auto returned_instance = builder.set_app_name("Nome applicazione")
+                    .request_validation_layers(true)
+                    .use_default_debug_messenger()
+                    .require_api_version(1, 3, 0)
+                    .set_headless(_config.headless)
+                    .build();
+    
+    vkb::Instance vkb_instance = returned_instance.value();
+
+    // Esporta nella classe l'istanza raccolta dal bootstrap e il debugger.
+    _instance = vkb_instance.instance;
+    _debug_messenger = vkb_instance.debug_messenger;
+
+	// Crea la superficie da passare alla finestra.
+	if (!_config.headless) {
+		SDL_Vulkan_CreateSurface(window, _instance, &_surface);
+	}
+
+
+    /* In questa sezione otteniamo le feature di vulkan 1.3 per il dynamic rendering
+       questo ci evita l'uso dei frame buffer e dei render pass dalle versioni 
+       precedenti di vulkan, inoltre possiamo usare sync2 per sincronizzare meglio
+       le risorse.
+    */
+    VkPhysicalDeviceVulkan13Features features{ .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_3_FEATURES };
+	features.dynamicRendering = true;
+	features.synchronization2 = true;
+
+    /* Qui prendiamo le feature di vulkan 1.2
+       nello specifico, per usare i puntatori alla GPU senza agganciare dei buffer,
+       e per avere textures non legate a nulla.
+    */ 
+    VkPhysicalDeviceVulkan12Features features12{ .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES };
+	features12.bufferDeviceAddress = true;
+	features12.descriptorIndexing = true;
+	features12.timelineSemaphore = true;
+
+	/*
+	* Feature della tabella bindless: array di descrittori senza dimensione fissa nella shader,
+	* elementi non registrati e registrazione dopo aver legato il set.
+	* Gli indici arrivano dai push constant, quindi sono uniformi: basta l'indicizzazione dinamica.
+	*/
+	features12.runtimeDescriptorArray = true;
+	features12.descriptorBindingPartiallyBound = true;
+	features12.descriptorBindingUpdateUnusedWhilePending = true;
+	features12.descriptorBindingStorageImageUpdateAfterBind = true;
+	features12.descriptorBindingSampledImageUpdateAfterBind = true;
+	features12.descriptorBindingStorageBufferUpdateAfterBind = true;
+
+	VkPhysicalDeviceFeatures coreFeatures{};
+	coreFeatures.shaderStorageImageArrayDynamicIndexing = true;
+	coreFeatures.shaderSampledImageArrayDynamicIndexing = true;
+	coreFeatures.shaderStorageBufferArrayDynamicIndexing = true;
+
+    
+    /* Seleziona una GPU con vk-bootstrap 
+       Vogliamo una GPU che possa scrivere nella superficie di SDL e che supporti 
+       vulkan 1.3 con le caratteristiche selezionate.
+	*/
+	
+    vkb::PhysicalDeviceSelector selector{vkb_instance};
+	
+	selector.set_minimum_version(1, 3)
+		.set_required_features(coreFeatures)
+		.set_required_features_13(features)
+		.set_required_features_12(features12);
+
+	// Senza superficie basta una GPU con una queue grafica, l'estensione swapchain non è richiesta.
+	if (!_config.headless) {
+		selector.set_surface(_surface);
+	}
+
+    vkb::PhysicalDevice physicalDevice = selector.select().value();
+
+	// Facoltativa: senza, VMA stima il budget di ogni heap invece di chiederlo al driver.
+	_memoryBudgetSupported = physicalDevice.enable_extension_if_present(VK_EXT_MEMORY_BUDGET_EXTENSION_NAME);
+
+    // Creiamo il dispositivo finale.
+	vkb::DeviceBuilder deviceBuilder{ physicalDevice };
+
+	vkb::Device vkbDevice = deviceBuilder.build().value();
+
+	// Prendi il dispositivo usato dall'intera applicazione.
+	_device = vkbDevice.device;
+	_chosenGPU = physicalDevice.physical_device;
+
+	// Ottieni le queue e i loro tipi
+	_graphicsQueue = vkbDevice.get_queue(vkb::QueueType::graphics).value();
+	_graphicsQueueFamily = vkbDevice.get_queue_index(vkb::QueueType::graphics).value();
+
+	/*
+	* Cerchiamo una queue compute separata dalla grafica: prima una famiglia solo compute,
+	* poi una qualsiasi famiglia compute senza grafica. Il calcolo dello sfondo può cosi
+	* sovrapporsi al lavoro grafico del frame precedente.
+	* Se non c'è, o con --no-async-compute, tutto resta sulla queue grafica.
+	*/
+	_computeQueue = _graphicsQueue;
+	_computeQueueFamily = _graphicsQueueFamily;
+
+	if (_config.asyncCompute) {
+		auto dedicatedQueue = vkbDevice.get_dedicated_queue(vkb::QueueType::compute);
+		auto separateQueue = vkbDevice.get_queue(vkb::QueueType::compute);
+
+		if (dedicatedQueue) {
+			_computeQueue = dedicatedQueue.value();
+			_computeQueueFamily = vkbDevice.get_dedicated_queue_index(vkb::QueueType::compute).value();
+		}
+		else if (separateQueue) {
+			_computeQueue = separateQueue.value();
+			_computeQueueFamily = vkbDevice.get_queue_index(vkb::QueueType::compute).value();
+		}
+	}
+
+	_asyncCompute = _computeQueueFamily != _graphicsQueueFamily;
+
+	_transferQueue = _graphicsQueue;
+	_transferQueueFamily = _graphicsQueueFamily;
+
+	auto dedicatedTransfer = vkbDevice.get_dedicated_queue(vkb::QueueType::transfer);
+	auto separateTransfer = vkbDevice.get_queue(vkb::QueueType::transfer);
+
+	if (dedicatedTransfer) {
+		_transferQueue = dedicatedTransfer.value();
+		_transferQueueFamily = vkbDevice.get_dedicated_queue_index(vkb::QueueType::transfer).value();
+	}
+	else if (separateTransfer) {
+		_transferQueue = separateTransfer.value();
+		_transferQueueFamily = vkbDevice.get_queue_index(vkb::QueueType::transfer).value();
+	}
+
+	fmt::print("Queue di trasferimento: famiglia {}\n", _transferQueueFamily);
+
+	if (_asyncCompute) {
+		fmt::print("Queue compute asincrona: famiglia {}\n", _computeQueueFamily);
+	}
+	else {
+		fmt::print("Queue compute asincrona non disponibile, uso la queue grafica\n");
+	}
+
+	/*
+	* Per i timestamp serve sapere quanti nanosecondi vale un incremento (timestampPeriod)
+	* e quanti bit validi hanno sulle queue grafica e compute (0 = non supportati).
+	*/
+	_gpuProperties = physicalDevice.properties;
+	_timestampPeriod = _gpuProperties.limits.timestampPeriod;
+	_timestampValidBits = physicalDevice.get_queue_families()[_graphicsQueueFamily].timestampValidBits;
+	_computeTimestampValidBits = physicalDevice.get_queue_families()[_computeQueueFamily].timestampValidBits;
+
+	// inizializza il memory allocator
+	VmaAllocatorCreateInfo allocatorInfo = {};
+	allocatorInfo.physicalDevice = _chosenGPU;
+	allocatorInfo.device = _device;
+	allocatorInfo.instance = _instance;
+	allocatorInfo.vulkanApiVersion = VK_API_VERSION_1_3;
+	allocatorInfo.flags = VMA_ALLOCATOR_CREATE_BUFFER_DEVICE_ADDRESS_BIT;
+	if (_memoryBudgetSupported) {
+		allocatorInfo.flags |= VMA_ALLOCATOR_CREATE_EXT_MEMORY_BUDGET_BIT;
+	}
+	vmaCreateAllocator(&allocatorInfo, &_allocator);
+
+	_memoryMonitor.init(_allocator);
+
+	_mainDeletionQueue.push_function([&]() {
+		vmaDestroyAllocator(_allocator); 
+		});
+
+	_deletionQueue.init(_device, _allocator);
+
+	_uploader.init(_device, _allocator, _transferQueue, _transferQueueFamily, _graphicsQueueFamily,
+				   size_t(_config.stagingMegabytes) * 1024 * 1024);
+
+	_memoryMonitor.track(_uploader.ring_allocation(), MemoryCategory::Staging);
+
+	_submitBatcher.init(_device, _graphicsQueue, _graphicsQueueFamily);
+
+	_mainDeletionQueue.push_function([&]() {
+		_uploader.destroy();
+		_submitBatcher.destroy();
+		});
+}
+
+// Nome leggibile di una modalità di presentazione, per i messaggi.
+static const char* present_mode_name(VkPresentModeKHR mode)
+{
+	switch (mode) {
+	case VK_PRESENT_MODE_IMMEDIATE_KHR:
+		return "IMMEDIATE";
+	case VK_PRESENT_MODE_MAILBOX_KHR:
+		return "MAILBOX";
+	case VK_PRESENT_MODE_FIFO_KHR:
+		return "FIFO";
+	case VK_PRESENT_MODE_FIFO_RELAXED_KHR:
+		return "FIFO_RELAXED";
+	default:
+		return "sconosciuta";
+	}
+}
+
+/*
+    Funzione che crea la swapchain, selezioniamo il formato di colore standard RGBA8, con profondità
+    di 8 bit per canale, rappresentando 256 combinazioni di colori possibili.
+
+    NOTA: La modalità FIFO (first in first out) di presentazione dei fotogrammi forza il VSync,
+          in modo che l'engine generi lo stesso numero dei fotogrammi supportati dal refresh rate del monitor.
+          La modalità usata dipende dalla politica in _config.presentPolicy, vedi choose_present_mode().
+
+	NOTA: RGBA8 è un formato dei colori Little-Endian, se vuoi big-endian, usa BGRA8
+
+    Inoltre, stiamo inoltrando la risoluzione delle immagini alla swapchain, perché le immagini devono 
+    avere la stessa risoluzione della finestra. Quando la finestra cambia dimensione la chain viene
+    ricostruita da resize_swapchain(), passando quella vecchia come oldSwapchain.
+*/
+void VulkanEngine::create_swapchain(uint32_t width, uint32_t height, VkSwapchainKHR oldSwapchain)
+{
+	vkb::SwapchainBuilder swapchainBuilder{ _chosenGPU,_device,_surface };
+
+	_presentMode = choose_present_mode(_config.presentPolicy);
+
+	_swapchainImageFormat = VK_FORMAT_R8G8B8A8_UNORM;
+
+	vkb::Swapchain vkbSwapchain = swapchainBuilder
+		//.use_default_format_selection() il formato delle immagini l'abbiamo selezionato, quindi questa funzione è commentata
+		.set_desired_format(VkSurfaceFormatKHR{ .format = _swapchainImageFormat, .colorSpace = VK_COLOR_SPACE_SRGB_NONLINEAR_KHR })
+		.set_desired_present_mode(_presentMode)
+		.set_desired_extent(width, height)
+		.add_image_usage_flags(VK_IMAGE_USAGE_TRANSFER_DST_BIT)
+		.set_old_swapchain(oldSwapchain)
+		// un'immagine per ogni frame in volo più quella mostrata a schermo.
+		.set_desired_min_image_count(_config.framesInFlight + 1)
+		.build()
+		.value();
+
+	_swapchainExtent = vkbSwapchain.extent;
+	//store swapchain and its related images
+	_swapchain = vkbSwapchain.swapchain;
+	_swapchainImages = vkbSwapchain.get_images().value();
+	_swapchainImageViews = vkbSwapchain.get_image_views().value();
+
+	VkSemaphoreCreateInfo semaphoreInfo = vkInit::semaphoreInfo(0);
+	_presentSemaphores.resize(_swapchainImages.size());
+
+	for (VkSemaphore& semaphore : _presentSemaphores) {
+		vkInit::VK_CHECK(vkCreateSemaphore(_device, &semaphoreInfo, nullptr, &semaphore));
+	}
+}
+
+/*
+* Sceglie la modalità di presentazione per la politica richiesta.
+*
+* Ogni politica ha un elenco di modalità in ordine di preferenza, prendiamo la prima
+* supportata dalla superficie. FIFO è garantita dalla specifica, quindi chiude ogni elenco.
+*/
+VkPresentModeKHR VulkanEngine::choose_present_mode(PresentPolicy policy) const
+{
+	uint32_t count = 0;
+	vkGetPhysicalDeviceSurfacePresentModesKHR(_chosenGPU, _surface, &count, nullptr);
+
+	std::vector<VkPresentModeKHR> supported(count);
+	vkGetPhysicalDeviceSurfacePresentModesKHR(_chosenGPU, _surface, &count, supported.data());
+
+	std::vector<VkPresentModeKHR> preferred;
+
+	switch (policy) {
+	case PresentPolicy::Vsync:
+		preferred = { VK_PRESENT_MODE_FIFO_KHR };
+		break;
+	case PresentPolicy::LowLatency:
+		preferred = { VK_PRESENT_MODE_MAILBOX_KHR, VK_PRESENT_MODE_FIFO_RELAXED_KHR, VK_PRESENT_MODE_FIFO_KHR };
+		break;
+	case PresentPolicy::Uncapped:
+		preferred = { VK_PRESENT_MODE_IMMEDIATE_KHR, VK_PRESENT_MODE_MAILBOX_KHR, VK_PRESENT_MODE_FIFO_KHR };
+		break;
+	case PresentPolicy::Relaxed:
+		preferred = { VK_PRESENT_MODE_FIFO_RELAXED_KHR, VK_PRESENT_MODE_FIFO_KHR };
+		break;
+	}
+
+	for (VkPresentModeKHR mode : preferred) {
+		if (std::find(supported.begin(), supported.end(), mode) != supported.end()) {
+			if (mode != preferred.front()) {
+				fmt::print("Modalità {} non supportata, uso {}\n", present_mode_name(preferred.front()),
+						   present_mode_name(mode));
+			}
+			return mode;
+		}
+	}
+
+	return VK_PRESENT_MODE_FIFO_KHR;
+}
+
+/*
+* Passa alla politica di presentazione successiva e ricostruisce la swapchain
+* all'inizio del prossimo frame, con lo stesso percorso del ridimensionamento.
+*/
+void VulkanEngine::cycle_present_policy()
+{
+	switch (_config.presentPolicy) {
+	case PresentPolicy::Vsync:
+		_config.presentPolicy = PresentPolicy::LowLatency;
+		break;
+	case PresentPolicy::LowLatency:
+		_config.presentPolicy = PresentPolicy::Uncapped;
+		break;
+	case PresentPolicy::Uncapped:
+		_config.presentPolicy = PresentPolicy::Relaxed;
+		break;
+	case PresentPolicy::Relaxed:
+		_config.presentPolicy = PresentPolicy::Vsync;
+		break;
+	}
+
+	fmt::print("Politica di presentazione: {}\n", vkConfig::present_policy_name(_config.presentPolicy));
+	_resizeRequested = true;
+}
+
+/*
+* Ricostruisce la swapchain con la dimensione attuale della finestra.
+*
+* La nuova chain viene creata passando quella vecchia come oldSwapchain, cosi il driver
+* può continuare a presentare le immagini già in coda durante il cambio.
+* Senza vkDeviceWaitIdle: la vecchia chain e le sue view vanno nel lotto aperto della deletion queue,
+* chiuso dal prossimo frame inviato, e vengono distrutte quando la GPU ha terminato quel frame e
+* quindi anche quelli in volo che usavano le vecchie immagini.
+*
+* L'immagine di disegno viene ricreata solo se la nuova chain è più grande della sua
+* capacità, altrimenti disegniamo in una sua porzione (_drawExtent).
+*
+* Con la finestra minimizzata la dimensione è 0: la richiesta resta in attesa.
+*/
+void VulkanEngine::resize_swapchain()
+{
+	int width = 0;
+	int height = 0;
+	SDL_Vulkan_GetDrawableSize(window, &width, &height);
+
+	if (width == 0 || height == 0) {
+		return;
+	}
+
+	VkSwapchainKHR oldSwapchain = _swapchain;
+	std::vector<VkImageView> oldImageViews = _swapchainImageViews;
+	std::vector<VkSemaphore> oldPresentSemaphores = _presentSemaphores;
+
+	create_swapchain(uint32_t(width), uint32_t(height), oldSwapchain);
+	_windowExtent = _swapchainExtent;
+
+	// la coda distrugge in ordine inverso: prima le view e i semafori, poi la swapchain.
+	_deletionQueue.push(oldSwapchain);
+	for (VkSemaphore semaphore : oldPresentSemaphores) {
+		_deletionQueue.push(semaphore);
+	}
+	for (VkImageView view : oldImageViews) {
+		_deletionQueue.push(view);
+	}
+
+	VkExtent3D capacity = _drawImage.imageExtent;
+	VkExtent2D required = scaled_draw_extent();
+
+	if (required.width > capacity.width || required.height > capacity.height) {
+		retire_draw_image();
+		create_draw_image({ std::max(required.width, capacity.width),
+							std::max(required.height, capacity.height) });
+		register_draw_image();
+	}
+
+	_resizeRequested = false;
+
+	fmt::print("Swapchain ricreata: {}x{} {} (immagine di disegno {}x{})\n", _swapchainExtent.width,
+			   _swapchainExtent.height, present_mode_name(_presentMode), _drawImage.imageExtent.width,
+			   _drawImage.imageExtent.height);
+}
+
+/*
+  Funzione che distrugge la catena di immagini.
+*/
+void VulkanEngine::destroy_swapchain()
+{
+	if (_swapchain == VK_NULL_HANDLE) {
+		return;
+	}
+
+	vkDestroySwapchainKHR(_device, _swapchain, nullptr);
+
+	// distruggi le risorse della chain
+	for (size_t i = 0; i < _swapchainImageViews.size(); i++) {
+		vkDestroyImageView(_device, _swapchainImageViews[i], nullptr);
+	}
+
+	for (VkSemaphore semaphore : _presentSemaphores) {
+		vkDestroySemaphore(_device, semaphore, nullptr);
+	}
+}
+
+
+/*
+  Funzione che elimina tutte le risorse usate.
+
+  Per testare che i layers funzionino correttamente, prova a distruggere l'istanza prima di tutto.
+*/
+void VulkanEngine::cleanup()
+{
+	if (bIsInitialized) {
+		/*
+		* Abbiamo creato la command pool con i buffer, aspettiamo che la GPU finisca e poi distruggiamo anch'essa.
+		* Siccome è l'oggetto più recente, distruggiamo prima esso, poi la swapchain e la superficie.
+		*/ 
+		vkDeviceWaitIdle(_device);
+
+		// ferma l'hot-reload e distruggi le pipeline ricostruite ma mai usate.
+		_shaderWatcher.stop();
+		for (PendingReload& reload : _pendingReloads) {
+			PipelineEntry entry = reload.result.get();
+			vkDestroyPipeline(_device, entry.pipeline, nullptr);
+			vkDestroyShaderModule(_device, entry.module, nullptr);
+		}
+		_pendingReloads.clear();
+
+		for (uint32_t i = 0; i < _framesInFlight; i++) {
+			vkDestroyCommandPool(_device, _frames[i].commandPool, nullptr);
+			for (ThreadCommandPool& threadPool : _frames[i]._threadCommands) {
+				threadPool.destroy(_device);
+			}
+			if (_frames[i].computeCommandPool != VK_NULL_HANDLE) {
+				vkDestroyCommandPool(_device, _frames[i].computeCommandPool, nullptr);
+				_frames[i]._computeTimestamps.destroy(_device);
+			}
+			_frames[i]._gpuTimestamps.destroy(_device);
+			
+			//destroy sync objects
+			vkDestroySemaphore(_device, _frames[i]._swapchainSemaphore, nullptr);
+		}
+
+		// la GPU è ferma: distruggiamo anche i lotti non ancora completati.
+		_deletionQueue.flush();
+
+		// consegna i fotogrammi headless ancora in attesa, la GPU ha finito.
+		for (HeadlessTarget& target : _headlessTargets) {
+			deliver_headless_frame(target);
+		}
+
+		//flush the global deletion queue
+		_mainDeletionQueue.flush();
+
+		// salva la cache delle pipeline per il prossimo avvio.
+		if (_pipelineCache.save(_device)) {
+			fmt::print("Pipeline cache salvata in {}\n", _pipelineCache.path);
+		}
+		_pipelineCache.destroy(_device);
+
+		destroy_swapchain();
+		if (_surface != VK_NULL_HANDLE) {
+			vkDestroySurfaceKHR(_instance, _surface, nullptr);
+		}
+		vkDestroyDevice(_device, nullptr);
+		
+		vkb::destroy_debug_utils_messenger(_instance, _debug_messenger);
+		vkDestroyInstance(_instance, nullptr);
+
+		_jobs.shutdown();
+		if (window) {
+			SDL_DestroyWindow(window);
+		}
+	}
+}
+
+
+
+void VulkanEngine::init_swapchain() {
+	_framesInFlight = _config.framesInFlight;
+
+	if (_config.headless) {
+		_swapchainImageFormat = VK_FORMAT_R8G8B8A8_UNORM;
+		_swapchainExtent = _windowExtent;
+	}
+	else {
+		create_swapchain(_windowExtent.width, _windowExtent.height);
+
+		/*
+		* Con più frame in volo che immagini nella swapchain, i frame in eccesso
+		* resterebbero comunque fermi in vkAcquireNextImageKHR.
+		*/
+		_framesInFlight = std::min(_framesInFlight, uint32_t(_swapchainImages.size()));
+	}
+
+	fmt::print("Frame in volo: {}\n", _framesInFlight);
+	
+	//La dimensione del disegno dell'immagine combacia con la finestra
+	create_draw_image(_swapchainExtent);
+
+	// Aggiungi alle queue da cancellare. L'immagine può essere ricreata da resize_swapchain(),
+	// quindi distruggiamo quella attuale al momento della pulizia.
+	_mainDeletionQueue.push_function([this]() {
+		vkDestroyImageView(_device, _drawImage.imageView, nullptr);
+		vmaDestroyImage(_allocator, _drawImage.image, _drawImage.allocation);
+		});
+
+	if (_config.headless) {
+		init_headless_targets();
+	}
+}
+
+/*
+* Crea l'immagine in cui disegnano le compute shader, in formato float a 16 bit.
+*
+* La sua dimensione è la capacità massima: il frame usa solo la porzione _drawExtent,
+* cosi ridurre la finestra non richiede di ricrearla.
+*/
+void VulkanEngine::create_draw_image(VkExtent2D extent)
+{
+	VkExtent3D drawImageExtent = {
+		extent.width,
+		extent.height,
+		1
+	};
+
+	//hardcode il formato di disegno a 16 bit float
+	_drawImage.imageFormat = VK_FORMAT_R16G16B16A16_SFLOAT;
+	_drawImage.imageExtent = drawImageExtent;
+	_drawImageState = ImageState::undefined();
+
+	VkImageUsageFlags drawImageUsages{};
+	drawImageUsages |= VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+	drawImageUsages |= VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+	drawImageUsages |= VK_IMAGE_USAGE_STORAGE_BIT;
+	drawImageUsages |= VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
+
+	VkImageCreateInfo rimg_info = vkInit::image_create_info(_drawImage.imageFormat, drawImageUsages, drawImageExtent);
+
+	//Allochiamo l'immagine da disegnare dalla memoria locale della GPU.
+	VmaAllocationCreateInfo rimg_allocinfo = {};
+	rimg_allocinfo.usage = VMA_MEMORY_USAGE_GPU_ONLY;
+	rimg_allocinfo.requiredFlags = VkMemoryPropertyFlags(VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+
+	//Alloca e crea l'immagine
+	vmaCreateImage(_allocator, &rimg_info, &rimg_allocinfo, &_drawImage.image, &_drawImage.allocation, nullptr);
+
+	//Costruisci un'anteprima per l'immagine da usare nel rendering.
+	VkImageViewCreateInfo rview_info = vkInit::imageview_create_info(_drawImage.imageFormat, _drawImage.image, 
+																	 VK_IMAGE_ASPECT_COLOR_BIT);
+
+	vkInit::VK_CHECK(vkCreateImageView(_device, &rview_info, nullptr, &_drawImage.imageView));
+
+	_memoryMonitor.track(_drawImage.allocation, MemoryCategory::DrawTargets);
+}
+
+/*
+* Manda l'immagine di disegno attuale e il suo indice bindless alla deletion queue,
+* prima di crearne una nuova: i frame in volo possono ancora usarla.
+*/
+void VulkanEngine::retire_draw_image()
+{
+	_memoryMonitor.untrack(_drawImage.allocation);
+
+	_deletionQueue.push(_drawImage.image, _drawImage.allocation);
+	_deletionQueue.push(_drawImage.imageView);
+	_deletionQueue.push_callback([](void* bindless, uint64_t handle) {
+		static_cast<BindlessHeap*>(bindless)->release_storage_image(uint32_t(handle));
+		}, &_bindless, _drawImageHandle);
+}
+
+// Porzione della swapchain in cui disegniamo con la scala attuale, almeno un pixel per lato.
+VkExtent2D VulkanEngine::scaled_draw_extent() const
+{
+	return { std::max(1u, uint32_t(_swapchainExtent.width * _renderScale)),
+			 std::max(1u, uint32_t(_swapchainExtent.height * _renderScale)) };
+}
+
+/*
+* Crea i target fuori schermo della modalità headless.
+*
+* Hanno lo stesso formato che avrebbe la swapchain, cosi il percorso di disegno
+* resta identico: l'immagine di disegno viene copiata nel target invece che
+* nell'immagine della swapchain.
+*
+* Se è impostata una callback, ogni target ha anche un buffer visibile dalla CPU
+* in cui copiare i pixel. Il buffer resta mappato e lo leggiamo solo dopo che
+* il frame è stato completato (semaforo timeline).
+*/
+void VulkanEngine::init_headless_targets()
+{
+	_headlessTargets.resize(_framesInFlight);
+
+	VkExtent3D targetExtent = { _swapchainExtent.width, _swapchainExtent.height, 1 };
+
+	for (HeadlessTarget& target : _headlessTargets) {
+		target.image.imageFormat = _swapchainImageFormat;
+		target.image.imageExtent = targetExtent;
+		target.image.imageView = VK_NULL_HANDLE;
+		target.readback = {};
+		target.frameNumber = 0;
+		target.pending = false;
+
+		VkImageCreateInfo img_info = vkInit::image_create_info(_swapchainImageFormat,
+			VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT, targetExtent);
+
+		VmaAllocationCreateInfo img_allocinfo = {};
+		img_allocinfo.usage = VMA_MEMORY_USAGE_GPU_ONLY;
+		img_allocinfo.requiredFlags = VkMemoryPropertyFlags(VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+
+		vkInit::VK_CHECK(vmaCreateImage(_allocator, &img_info, &img_allocinfo, &target.image.image,
+										&target.image.allocation, nullptr));
+		_memoryMonitor.track(target.image.allocation, MemoryCategory::DrawTargets);
+
+		if (_headlessCallback) {
+			target.readback = vkutil::create_buffer(_allocator,
+				size_t(_swapchainExtent.width) * _swapchainExtent.height * 4,
+				VK_BUFFER_USAGE_TRANSFER_DST_BIT, VMA_MEMORY_USAGE_GPU_TO_CPU, VMA_ALLOCATION_CREATE_MAPPED_BIT);
+			_memoryMonitor.track(target.readback.allocation, MemoryCategory::Readback);
+		}
+	}
+
+	_mainDeletionQueue.push_function([&]() {
+		for (HeadlessTarget& target : _headlessTargets) {
+			vmaDestroyImage(_allocator, target.image.image, target.image.allocation);
+			if (target.readback.buffer != VK_NULL_HANDLE) {
+				vkutil::destroy_buffer(_allocator, target.readback);
+			}
+		}
+		_headlessTargets.clear();
+		});
+}
+
+/*
+* Consegna alla callback un fotogramma headless già completato dalla GPU.
+*
+* Va chiamata solo dopo aver atteso il frame che ha scritto nel target.
+* Il buffer potrebbe non essere coerente con la CPU, quindi invalidiamo
+* la cache prima di leggerlo.
+*/
+void VulkanEngine::deliver_headless_frame(HeadlessTarget& target)
+{
+	if (!target.pending) {
+		return;
+	}
+	target.pending = false;
+
+	if (!_headlessCallback || target.readback.buffer == VK_NULL_HANDLE) {
+		return;
+	}
+
+	vmaInvalidateAllocation(_allocator, target.readback.allocation, 0, VK_WHOLE_SIZE);
+
+	HeadlessFrame frame{};
+	frame.frameNumber = target.frameNumber;
+	frame.extent = { target.image.imageExtent.width, target.image.imageExtent.height };
+	frame.format = target.image.imageFormat;
+	frame.pixels = target.readback.info.pMappedData;
+	frame.rowPitch = size_t(frame.extent.width) * 4;
+
+	_headlessCallback(frame);
+}
+
+/*
+* Crea una command pool per i comandi da inviare alla queue
+* la pool viene resettata per intero all'inizio del frame (vkResetCommandPool),
+* quindi non serve permettere il reset dei command buffer individuali.
+* 
+* il for loop crea le command pool definite, più una pool per ogni worker del JobSystem
+* in cui registrare i command buffer secondari, e una per i thread esterni al sistema.
+* 
+* Le due strutture info contengono le informazioni riguardo
+* la command pool e i command buffer.
+*/
+void VulkanEngine::init_commands() {
+
+	_frames.resize(_framesInFlight);
+
+	for (uint32_t i = 0; i < _framesInFlight; i++) {	
+		VkCommandPoolCreateInfo commandPoolInfo{};
+		commandPoolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+		commandPoolInfo.pNext = nullptr;
+		commandPoolInfo.flags = 0;
+		commandPoolInfo.queueFamilyIndex = _graphicsQueueFamily;
+
+		vkInit::VK_CHECK(vkCreateCommandPool(_device, &commandPoolInfo, nullptr, &_frames[i].commandPool));
+		
+		VkCommandBufferAllocateInfo commandBufferInfo = {};
+		commandBufferInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+		commandBufferInfo.pNext = nullptr;
+		commandBufferInfo.commandPool = _frames[i].commandPool;
+		commandBufferInfo.commandBufferCount = 1;
+		commandBufferInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+
+		vkInit::VK_CHECK(vkAllocateCommandBuffers(_device, &commandBufferInfo, &_frames[i].commandBuffer));
+
+		_frames[i]._threadCommands.resize(_jobs.worker_count() + 1);
+		for (ThreadCommandPool& threadPool : _frames[i]._threadCommands) {
+			threadPool.init(_device, _graphicsQueueFamily);
+		}
+
+		_frames[i]._gpuTimestamps.init(_device, _timestampValidBits);
+
+		if (_asyncCompute) {
+			VkCommandPoolCreateInfo computePoolInfo = vkInit::command_pool_create_info(_computeQueueFamily, 0);
+			vkInit::VK_CHECK(vkCreateCommandPool(_device, &computePoolInfo, nullptr, &_frames[i].computeCommandPool));
+
+			VkCommandBufferAllocateInfo computeBufferInfo = vkInit::command_buffer_allocate_info(
+				_frames[i].computeCommandPool, 1, VK_COMMAND_BUFFER_LEVEL_PRIMARY);
+			vkInit::VK_CHECK(vkAllocateCommandBuffers(_device, &computeBufferInfo, &_frames[i].computeCommandBuffer));
+
+			_frames[i]._computeTimestamps.init(_device, _computeTimestampValidBits);
+		}
+	}
+}
+
+
+/*
+* Una volta creati i command pool e buffer per inviare i comandi alla
+* GPU, dobbiamo sincronizzare queste strutture tra GPU e CPU per tracciarne
+* lo stato di esecuzione.
+*
+* Ogni slot ha il semaforo binario per l'acquisizione dell'immagine, mentre la fine
+* dei frame viene tracciata da un unico semaforo timeline che parte da 0.
+*/
+void VulkanEngine::init_sync_structures()
+{
+	VkSemaphoreCreateInfo semaphoreInfo = vkInit::semaphoreInfo(0);
+
+	for (uint32_t i = 0; i < _framesInFlight; i++) {
+		vkInit::VK_CHECK(vkCreateSemaphore(_device, &semaphoreInfo, nullptr, &_frames[i]._swapchainSemaphore));
+	}
+
+	VkSemaphoreTypeCreateInfo timelineInfo = vkInit::timeline_semaphore_info(0);
+	VkSemaphoreCreateInfo timelineSemaphoreInfo = vkInit::semaphoreInfo(0);
+	timelineSemaphoreInfo.pNext = &timelineInfo;
+
+	vkInit::VK_CHECK(vkCreateSemaphore(_device, &timelineSemaphoreInfo, nullptr, &_frameTimeline));
+
+	if (_asyncCompute) {
+		vkInit::VK_CHECK(vkCreateSemaphore(_device, &timelineSemaphoreInfo, nullptr, &_computeTimeline));
+	}
+
+	_mainDeletionQueue.push_function([&]() {
+		vkDestroySemaphore(_device, _frameTimeline, nullptr);
+		if (_computeTimeline != VK_NULL_HANDLE) {
+			vkDestroySemaphore(_device, _computeTimeline, nullptr);
+		}
+		});
+}
+
+bool VulkanEngine::is_frame_complete(uint64_t frameNumber) const
+{
+	uint64_t completed = 0;
+	vkInit::VK_CHECK(vkGetSemaphoreCounterValue(_device, _frameTimeline, &completed));
+
+	return completed >= frame_timeline_value(frameNumber);
+}
+
+/*
+* Blocca la CPU finché la GPU non ha completato il frame indicato (e quindi tutti i precedenti,
+* che sulla stessa queue terminano in ordine).
+*/
+void VulkanEngine::wait_for_frame(uint64_t frameNumber) const
+{
+	uint64_t value = frame_timeline_value(frameNumber);
+
+	VkSemaphoreWaitInfo waitInfo = {};
+	waitInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO;
+	waitInfo.pNext = nullptr;
+	waitInfo.flags = 0;
+	waitInfo.semaphoreCount = 1;
+	waitInfo.pSemaphores = &_frameTimeline;
+	waitInfo.pValues = &value;
+
+	vkInit::VK_CHECK(vkWaitSemaphores(_device, &waitInfo, UINT64_MAX));
+}
+
+/*
+* Funzione per disegnare sullo schermo.
+* 
+* NOTA: L'ideale sarebbe fare tutto tramite shaders, e non fare 
+* computazioni tramite CPU. questo codice verrà rimosso più in la.
+* 
+* Attendi che la GPU abbia terminato il frame che usava lo stesso slot,
+* attendendo il suo valore sul semaforo timeline. A differenza di una fence
+* non c'è nulla da resettare: ogni frame segnala un valore più alto.
+* 
+* Per sapere senza bloccarsi se la GPU sta ancora eseguendo un frame, usa is_frame_complete().
+* 
+* Poi, richiediamo l'indice dell'immagine nella swapchain, se nessuna immagine è
+* disponibile, il thread verrà bloccato per 1 secondo per ottenere un'immagine disponibile.
+* 
+* 
+*/
+
+
+/*
+* Funzione di init dei descriptors.
+* 
+* Le shader accedono alle risorse tramite la tabella bindless (_bindless): un solo
+* descriptor set con un array di storage image, uno di immagini campionate e uno di
+* storage buffer, legato una volta sola. Ogni risorsa viene registrata nella tabella
+* e riceve un indice, che la shader legge dai push constant.
+* 
+* Registrando una nuova immagine non servono nuovi layout né nuove pool,
+* e il numero di risorse può crescere senza cambiare i descriptor set legati.
+* 
+* Per questo i frame non hanno pool di descrittori proprie: i dati dinamici del frame
+* passano dall'arena (_frameArena) e vengono letti tramite il loro indirizzo.
+*/
+void VulkanEngine::init_descriptors()
+{
+	for (FrameData& frame : _frames) {
+		// Riscritta ad ogni frame: memoria visibile dalla CPU, letta direttamente dalla GPU.
+		frame._frameArena.init(_allocator, 1024 * 1024, _gpuProperties.limits);
+		_memoryMonitor.track(frame._frameArena.buffer.allocation, MemoryCategory::FrameArenas);
+	}
+
+	_bindless.init(_device, _chosenGPU, VK_SHADER_STAGE_COMPUTE_BIT);
+
+	register_draw_image();
+
+	_mainDeletionQueue.push_function([&]() {
+		for (FrameData& frame : _frames) {
+			frame._frameArena.destroy(_allocator);
+		}
+
+		_bindless.destroy(_device);
+	});
+}
+
+/*
+* Registra la view dell'immagine di disegno nella tabella bindless.
+*
+* Quando l'immagine viene ricreata prende un indice nuovo: quello vecchio può essere
+* ancora usato dai frame in volo, e viene rilasciato dalla deletion queue.
+* Senza un indice per l'immagine di disegno non possiamo disegnare nulla, quindi
+* una tabella piena qui ferma il programma.
+*/
+void VulkanEngine::register_draw_image()
+{
+	_drawImageHandle = _bindless.register_storage_image(_device, _drawImage.imageView, VK_IMAGE_LAYOUT_GENERAL);
+
+	if (_drawImageHandle == FreeListAllocator::invalidIndex) {
+		fmt::print("Nessun indice bindless libero per l'immagine di disegno\n");
+		abort();
+	}
+}
+
+/*
+* Funzione che inizializza le pipeline in background.
+* 
+* Per creare una pipeline è necessario avere un array di layout 
+  di DescriptorSets e altre configurazioni come Push-Constants.
+
+  In questo caso non ne abbiamo bisogno per questa shader.
+
+  Ora creiamo l'oggetto pipeline vero e proprio aggiungendo lo 
+  shader module e altre informazioni tramite VkComputePipelineCreateInfo,
+
+  Dipende  dalle strutture stageInfo che richiede che la shader sia compilata
+
+  e dalla computePipelineCreateInfo, che richiede i dati compilati della struttura
+  precedente.
+
+  Se la compilazione della shader fallisce, allora il programma crasha.
+
+  Nota che l'entry point della shader in questo caso è main, ma se vogliamo
+  più shader module con diversi entry point, possiamo cambiare il nome
+  della funzione nella shader per poi farne riferimento qui.
+
+  Infine come ogni oggetto, distruggiamo lo shader module creato,
+  il layout della pipeline e la pipeline stessa.
+* 
+*/
+
+void VulkanEngine::init_pipelines()
+{
+	_pipelineCache.init(_device, _gpuProperties, _config.pipelineCachePath);
+
+	auto start = std::chrono::steady_clock::now();
+
+	init_background_pipelines();
+
+	std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+	fmt::print("Pipeline create in {:.2f} ms (avvio {})\n", elapsed.count(),
+			   _pipelineCache.warm ? "a caldo, cache caricata" : "a freddo");
+}
+
+/*
+* Funzione che inizializza una pipeline, in questo caso una compute
+* pipeline.
+* 
+* La funzione scansiona la directory delle shaders e cerca i file compilati in 
+* 
+* SPRI-V da GLSL, per ogni shader valida crea una pipeline. Il caricamento delle shader
+* e la compilazione delle pipeline avvengono in parallelo sui worker del JobSystem,
+* cosi il tempo di avvio scala con il numero dei core e non con quello delle shader.
+* 
+* Ogni shader diventa un effetto di sfondo nel registro delle pipeline, tutti con lo
+* stesso layout "background". L'effetto disegnato viene cercato per nome ad ogni frame,
+* all'avvio è quello scelto con --effect, se manca il primo in ordine alfabetico.
+*/
+void VulkanEngine::init_background_pipelines()
+{
+	VkPipelineLayoutCreateInfo computeLayout{};
+	computeLayout.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+	computeLayout.pNext = nullptr;
+	computeLayout.pSetLayouts = &_bindless.layout;
+	computeLayout.setLayoutCount = 1;
+
+	// L'indice dell'immagine da scrivere arriva alla shader nei push constant.
+	VkPushConstantRange pushConstants{};
+	pushConstants.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+	pushConstants.offset = 0;
+	pushConstants.size = sizeof(BackgroundPushConstants);
+
+	computeLayout.pPushConstantRanges = &pushConstants;
+	computeLayout.pushConstantRangeCount = 1;
+
+	VkPipelineLayout backgroundLayout;
+	vkInit::VK_CHECK(vkCreatePipelineLayout(_device, &computeLayout, nullptr, &backgroundLayout));
+	_pipelines.add_layout("background", backgroundLayout);
+
+	const std::string& shaderDir = _config.shaderDir;
+
+	/*
+	* Con l'archivio basta aprire e mappare un file, senza leggere ogni shader.
+	* Un archivio vuoto, o più vecchio di un file .spv della cartella, viene ignorato.
+	*/
+	ShaderBundle bundle;
+	std::vector<ComputePipelineDesc> descs;
+
+	if (!_config.shaderBundle.empty() && bundle.open(_config.shaderBundle)) {
+		if (bundle.count() == 0 || bundle.is_outdated(shaderDir)) {
+			fmt::print("Archivio delle shader {} vuoto o non aggiornato, uso la cartella {}\n",
+					   _config.shaderBundle, shaderDir);
+			bundle.close();
+		}
+		else {
+			descs = vkutil::bundled_compute_shaders(bundle, backgroundLayout);
+			fmt::print("Shader lette dall'archivio {} ({})\n", _config.shaderBundle, descs.size());
+		}
+	}
+
+	if (descs.empty()) {
+		descs = vkutil::find_compute_shaders(shaderDir, backgroundLayout);
+	}
+
+	for (PipelineEntry& entry : vkutil::build_compute_pipelines(_device, _pipelineCache.cache, _jobs, descs)) {
+		if (_pipelines.find(entry.name) == nullptr) {
+			_backgroundEffects.push_back(entry.name);
+		}
+		_pipelines.add(_device, std::move(entry));
+	}
+
+	// i module sono creati, il codice dell'archivio non serve più.
+	bundle.close();
+
+	if (_backgroundEffects.empty()) {
+		fmt::print("Nessuna compute shader trovata in {}\n", shaderDir);
+		abort();
+	}
+
+	_backgroundEffect = _config.backgroundEffect;
+	if (_pipelines.find(_backgroundEffect) == nullptr) {
+		_backgroundEffect = _backgroundEffects.front();
+	}
+	fmt::print("Effetto di sfondo: {}\n", _backgroundEffect);
+
+	_mainDeletionQueue.push_function([&]() {
+		_pipelines.destroy(_device);
+		});
+
+	if (_config.hotReload) {
+		_shaderWatcher.start(shaderDir);
+	}
+}
+
+/*
+* Hot-reload delle shader, chiamata all'inizio di ogni frame.
+*
+* Per ogni file .spv modificato avviamo la ricostruzione della sua pipeline sul JobSystem,
+* con lo stesso layout della voce esistente, senza bloccare il rendering.
+* Un file nuovo diventa un nuovo effetto di sfondo. Se l'hash del contenuto è uguale
+* a quello della voce esistente (file riscritto uguale, o uguale a quello dell'archivio)
+* la pipeline non viene ricreata.
+*
+* Le pipeline pronte vengono scambiate nel registro prima di registrare il frame.
+* Quelle vecchie possono essere ancora in uso dai frame in volo, quindi le mandiamo
+* alla deletion queue: verranno distrutte quando la GPU avrà finito il frame corrente.
+*/
+void VulkanEngine::process_shader_reloads()
+{
+	for (ShaderChange& change : _shaderWatcher.poll_changes()) {
+		ComputePipelineDesc desc;
+		desc.name = vkutil::shader_name(change.path);
+		desc.shaderPath = change.path;
+
+		const PipelineEntry* existing = _pipelines.find(desc.name);
+		desc.layout = existing ? existing->layout : _pipelines.find_layout("background");
+		desc.skipHash = existing ? existing->contentHash : 0;
+		desc.copyFile = true;
+
+		VkDevice device = _device;
+		VkPipelineCache cache = _pipelineCache.cache;
+
+		_pendingReloads.push_back({ desc.name, _jobs.submit([device, cache, desc]() {
+			return vkutil::build_compute_pipeline(device, cache, desc);
+		}), change.detected });
+	}
+
+	for (auto it = _pendingReloads.begin(); it != _pendingReloads.end();) {
+		if (it->result.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+			++it;
+			continue;
+		}
+
+		PipelineEntry entry = it->result.get();
+		std::chrono::duration<double, std::milli> latency = std::chrono::steady_clock::now() - it->detected;
+
+		const PipelineEntry* existing = _pipelines.find(it->name);
+
+		if (entry.pipeline == VK_NULL_HANDLE && existing && entry.contentHash == existing->contentHash) {
+			fmt::print("Shader {} invariata, nessun hot-reload\n", it->name);
+		}
+		else if (entry.pipeline == VK_NULL_HANDLE) {
+			fmt::print("Hot-reload di {} fallito, resta la pipeline precedente\n", it->name);
+		}
+		else {
+			uint32_t index = _pipelines.find_index(entry.name);
+
+			if (index == PipelineRegistry::invalidIndex) {
+				_backgroundEffects.insert(std::upper_bound(_backgroundEffects.begin(), _backgroundEffects.end(), entry.name),
+										  entry.name);
+				_pipelines.add(_device, std::move(entry));
+			}
+			else {
+				PipelineEntry old = _pipelines.replace(index, std::move(entry));
+
+				_deletionQueue.push(old.module);
+				_deletionQueue.push(old.pipeline);
+			}
+
+			fmt::print("Hot-reload di {} in {:.2f} ms\n", it->name, latency.count());
+		}
+
+		it = _pendingReloads.erase(it);
+	}
+}
+
+/*
+* Passa all'effetto di sfondo successivo (step = 1) o precedente (step = -1).
+* Le pipeline sono già tutte create, quindi il cambio vale dal prossimo frame.
+*/
+void VulkanEngine::cycle_background_effect(int step)
+{
+	auto it = std::find(_backgroundEffects.begin(), _backgroundEffects.end(), _backgroundEffect);
+	int count = int(_backgroundEffects.size());
+	int current = it != _backgroundEffects.end() ? int(it - _backgroundEffects.begin()) : 0;
+
+	_backgroundEffect = _backgroundEffects[((current + step) % count + count) % count];
+	fmt::print("Effetto di sfondo: {}\n", _backgroundEffect);
+}
+
+
+/*
+* Disegna e invia un fotogramma. Ritorna false se il frame non è stato inviato
+* (swapchain da ricostruire), in quel caso non va contato.
+*/
+bool VulkanEngine::draw() {
+
+	using clock = std::chrono::steady_clock;
+	using ms = std::chrono::duration<double, std::milli>;
+
+	auto frameStart = clock::now();
+	_lastFrameTimings = {};
+	_lastFrameTimings.frameMs = _frameNumber == 0 ? 0.0 : ms(frameStart - _lastFrameStart).count();
+	_lastFrameStart = frameStart;
+
+	/*
+	* Prima di riusare lo slot di questo frame attendiamo il frame che lo usava,
+	* cioè quello di _framesInFlight fotogrammi fa. fenceWaitMs misura questa attesa.
+	*/
+	if (uint64_t(_frameNumber) >= _framesInFlight) {
+		wait_for_frame(uint64_t(_frameNumber) - _framesInFlight);
+	}
+	_lastFrameTimings.fenceWaitMs = ms(clock::now() - frameStart).count();
+	
+	// distrugge gli oggetti dei frame già completati, compreso quello appena atteso.
+	uint64_t completedValue = 0;
+	vkInit::VK_CHECK(vkGetSemaphoreCounterValue(_device, _frameTimeline, &completedValue));
+	_deletionQueue.collect(completedValue);
+
+	get_current_frame()._frameArena.reset();
+
+	/*
+	* Una swapchain non più valida (OUT_OF_DATE) o non più ottimale (SUBOPTIMAL) per la finestra
+	* non è un errore: la ricostruiamo qui, all'inizio del frame.
+	* Se l'acquisizione fallisce usciamo senza inviare nulla: il numero del frame non
+	* avanza e il prossimo tentativo riusa lo stesso slot. Per questo lo facciamo prima
+	* del lavoro da eseguire una sola volta per frame (ricaricamenti, memoria, tempi GPU).
+	*
+	* Gli oggetti ritirati da resize_swapchain() restano nel lotto aperto anche se usciamo:
+	* collect() non lo tocca, e viene chiuso solo dal primo frame che arriva all'invio.
+	* Riprovare con lo slot già atteso non può quindi distruggerli prima del tempo.
+	*
+	* L'attesa dell'immagine dura al massimo un secondo, così il ciclo degli eventi non resta
+	* bloccato. Allo scadere (VK_TIMEOUT, o VK_NOT_READY) il semaforo non viene segnalato,
+	* quindi saltiamo il frame e riproviamo con lo stesso semaforo al giro successivo.
+	*/
+	uint32_t swapchainImageIndex = 0;
+	if (!_config.headless) {
+		if (_resizeRequested) {
+			resize_swapchain();
+		}
+		if (_resizeRequested) {
+			return false;
+		}
+
+		auto acquireStart = clock::now();
+		VkResult acquireResult = vkAcquireNextImageKHR(_device, _swapchain, 1000000000,
+			get_current_frame()._swapchainSemaphore, nullptr, &swapchainImageIndex);
+		_lastFrameTimings.acquireMs = ms(clock::now() - acquireStart).count();
+
+		if (acquireResult == VK_ERROR_OUT_OF_DATE_KHR) {
+			_resizeRequested = true;
+			return false;
+		}
+		if (acquireResult == VK_TIMEOUT || acquireResult == VK_NOT_READY) {
+			return false;
+		}
+		if (acquireResult == VK_SUBOPTIMAL_KHR) {
+			_resizeRequested = true;
+		}
+		else {
+			vkInit::VK_CHECK(acquireResult);
+		}
+	}
+
+	// Confine tra due frame: qui possiamo sostituire le pipeline ricaricate.
+	process_shader_reloads();
+
+	// Anche l'immagine di disegno può essere ricreata, se la memoria GPU scarseggia.
+	update_memory_pressure();
+
+	// Invia insieme le copie accodate dall'ultimo frame, senza attenderle.
+	_uploader.flush();
+
+	// L'attesa del timeline garantisce che i timestamp di questo slot siano pronti.
+	get_current_frame()._gpuTimestamps.collect(_device, _timestampPeriod, _gpuTimings);
+	if (_asyncCompute) {
+		std::vector<GpuScopeTiming> computeTimings;
+		get_current_frame()._computeTimestamps.collect(_device, _timestampPeriod, computeTimings);
+		_gpuTimings.insert(_gpuTimings.begin(), computeTimings.begin(), computeTimings.end());
+	}
+	log_gpu_timings();
+
+	// In headless, il target di questo frame è stato scritto _framesInFlight fotogrammi fa ed è pronto.
+	HeadlessTarget* headlessTarget = nullptr;
+	if (_config.headless) {
+		headlessTarget = &_headlessTargets[_frameNumber % _framesInFlight];
+		deliver_headless_frame(*headlessTarget);
+	}
+
+	/*
+	* Invia il lavoro fuori dal frame accodato dall'ultimo frame. Lo facciamo dopo l'acquisizione
+	* dell'immagine, cosi l'invio di questo frame, che lo attende, è sicuro.
+	*/
+	uint64_t batchWaitValue = _submitBatcher.flush();
+
+	/*
+	* Il frame precedente in questo slot è completato: resettiamo in blocco la pool del
+	* command buffer primario e quelle dei worker, con tutti i secondari registrati.
+	*/
+	vkInit::VK_CHECK(vkResetCommandPool(_device, get_current_frame().commandPool, 0));
+	for (ThreadCommandPool& threadPool : get_current_frame()._threadCommands) {
+		threadPool.reset(_device);
+	}
+
+	//inizia la registrazione del command buffer, lo useremo una sola volta, il flag indica questo a Vulkan.
+	VkCommandBufferBeginInfo commandBufferBeginInfo = vkInit::commandBufferBeginInfo(VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT);
+
+	// disegniamo solo la porzione dell'immagine grande quanto la swapchain ridotta da _renderScale,
+	// la copia nella swapchain la riporta a piena dimensione.
+	VkExtent2D scaledExtent = scaled_draw_extent();
+	_drawExtent.width = std::min(scaledExtent.width, _drawImage.imageExtent.width);
+	_drawExtent.height = std::min(scaledExtent.height, _drawImage.imageExtent.height);
+
+	update_frame_parameters();
+
+	// Lo sfondo viene inviato subito alla queue compute, mentre qui registriamo il resto del frame.
+	if (_asyncCompute) {
+		submit_async_compute();
+	}
+
+	vkInit::VK_CHECK(vkBeginCommandBuffer(get_current_frame().commandBuffer, &commandBufferBeginInfo));
+
+	VkCommandBuffer cmd = get_current_frame().commandBuffer;
+	GpuTimestamps& timestamps = get_current_frame()._gpuTimestamps;
+
+	timestamps.reset(cmd);
+	uint32_t frameScope = timestamps.begin_scope(cmd, "frame");
+
+	// Le risorse caricate e completate diventano utilizzabili da questo frame.
+	uint64_t uploadWaitValue = _uploader.acquire_completed(cmd);
+
+	/*
+	* Il frame è descritto come grafo di passaggi: ognuno dichiara le immagini che legge e scrive
+	* e il grafo inserisce le barriere con gli stage reali (scrittura compute -> lettura del blit -> presentazione).
+	* Ogni passaggio ha il proprio blocco di timestamp, che comprende anche le sue barriere.
+	*/
+	RenderGraph graph;
+
+	// L'immagine di disegno viene sovrascritta completamente: il grafo ne scarta il contenuto precedente.
+	uint32_t drawImage = graph.import_image("draw", _drawImage.image, _drawImageState);
+
+	/*
+	* La funzione principale che disegna sullo schermo. Qui possiamo inserire altri passaggi di disegno in sequenza.
+	* Con la queue compute asincrona lo sfondo è già stato inviato: la queue grafica acquisisce
+	* l'immagine di disegno dalla famiglia compute, direttamente nel layout della copia.
+	*/
+	if (_asyncCompute) {
+		GpuScope scope(timestamps, cmd, "acquire");
+		ImageBarrierBatch barriers;
+		barriers.acquire(_drawImage.image, _drawImageState, ImageState::transfer_src(),
+						 _computeQueueFamily, _graphicsQueueFamily);
+		barriers.flush(cmd);
+	}
+	else {
+		graph.add_pass("background", { RenderGraph::write(drawImage, ImageState::compute_write()) },
+			[this](VkCommandBuffer cmd) { draw_background(cmd); });
+	}
+
+	// Lo stato dell'immagine di destinazione vale solo per questo frame.
+	ImageState targetState = headlessTarget ? ImageState::undefined() : ImageState::acquired();
+
+	if (headlessTarget) {
+		// Al posto della swapchain copiamo nel target fuori schermo, e se richiesto nel buffer di lettura.
+		VkImage targetImage = headlessTarget->image.image;
+		uint32_t target = graph.import_image("headless", targetImage, targetState);
+
+		graph.add_pass("blit", { RenderGraph::read(drawImage, ImageState::transfer_src()),
+								 RenderGraph::write(target, ImageState::transfer_dst()) },
+			[this, targetImage](VkCommandBuffer cmd) {
+				vkutil::copy_image_to_image(cmd, _drawImage.image, targetImage, _drawExtent, _swapchainExtent);
+			});
+
+		if (headlessTarget->readback.buffer != VK_NULL_HANDLE) {
+			// Il buffer di lettura non è tracciato dal grafo, quindi il passaggio non va mai scartato.
+			VkBuffer readback = headlessTarget->readback.buffer;
+			graph.add_pass("readback", { RenderGraph::read(target, ImageState::transfer_src()) },
+				[this, targetImage, readback](VkCommandBuffer cmd) {
+					vkutil::copy_image_to_buffer(cmd, targetImage, readback, _swapchainExtent);
+
+					// Rende la copia visibile alla CPU, che legge il buffer mappato dopo l'attesa del frame.
+					VkBufferMemoryBarrier2 barrier = { .sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER_2 };
+					barrier.pNext = nullptr;
+					barrier.srcStageMask = VK_PIPELINE_STAGE_2_COPY_BIT;
+					barrier.srcAccessMask = VK_ACCESS_2_TRANSFER_WRITE_BIT;
+					barrier.dstStageMask = VK_PIPELINE_STAGE_2_HOST_BIT;
+					barrier.dstAccessMask = VK_ACCESS_2_HOST_READ_BIT;
+					barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+					barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+					barrier.buffer = readback;
+					barrier.offset = 0;
+					barrier.size = VK_WHOLE_SIZE;
+
+					VkDependencyInfo depInfo = {};
+					depInfo.sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO;
+					depInfo.pNext = nullptr;
+					depInfo.bufferMemoryBarrierCount = 1;
+					depInfo.pBufferMemoryBarriers = &barrier;
+					vkCmdPipelineBarrier2(cmd, &depInfo);
+				}, true);
+		}
+
+		graph.mark_output(target);
+
+		headlessTarget->frameNumber = _frameNumber;
+		headlessTarget->pending = true;
+	}
+	else {
+		VkImage swapchainImage = _swapchainImages[swapchainImageIndex];
+		uint32_t swapchain = graph.import_image("swapchain", swapchainImage, targetState);
+
+		// esegui una copia dell'immagine disegnata nella swapchain
+		graph.add_pass("blit", { RenderGraph::read(drawImage, ImageState::transfer_src()),
+								 RenderGraph::write(swapchain, ImageState::transfer_dst()) },
+			[this, swapchainImage](VkCommandBuffer cmd) {
+				vkutil::copy_image_to_image(cmd, _drawImage.image, swapchainImage, _drawExtent, _swapchainExtent);
+			});
+
+		// al termine la swapchain va lasciata in "presentazione" cosi da mostrare l'immagine.
+		graph.mark_output(swapchain, ImageState::present());
+	}
+
+	/*
+	* Con --parallel-recording i passaggi vengono registrati dai worker in command buffer secondari,
+	* ognuno dalla pool del proprio thread, mentre questo thread registra le barriere nel primario.
+	*/
+	if (_config.parallelRecording) {
+		FrameData& frame = get_current_frame();
+		graph.execute(cmd, timestamps, _config.fullBarriers, &_jobs, [this, &frame]() {
+			return frame._threadCommands[_jobs.current_worker()].begin_secondary(_device);
+			});
+	}
+	else {
+		graph.execute(cmd, timestamps, _config.fullBarriers);
+	}
+	_renderGraphStats = graph.stats;
+
+	timestamps.end_scope(cmd, frameScope);
+
+	//Finalizza il command buffer (non possiamo aggiungere comandi, ma possiamo eseguirlo)
+	vkInit::VK_CHECK(vkEndCommandBuffer(get_current_frame().commandBuffer));
+
+
+	/*
+	* Prepara l'invio alla queue
+	* vogliamo aspettare il segnale del _swapchainSemaphore in quanto indica quando la swapchain è pronta.
+	* invieremo il segnale al semaforo di presentazione dell'immagine per indicare che il rendering è finito,
+	* e il valore di questo frame al semaforo timeline.
+	* Con la queue compute asincrona attendiamo anche lo sfondo, prima della copia,
+	* e il semaforo del caricatore se questo frame acquisisce delle risorse caricate.
+	* Il lavoro fuori dal frame inviato all'inizio di draw() precede il frame sulla stessa queue,
+	* ma senza attenderne il semaforo non ci sarebbe nessuna garanzia di ordine tra i due.
+	*/
+
+	VkCommandBufferSubmitInfo cmdinfo = vkInit::command_buffer_submit_info(get_current_frame().commandBuffer);
+
+	VkSemaphoreSubmitInfo waitInfos[4];
+	uint32_t waitCount = 0;
+
+	if (!_config.headless) {
+		waitInfos[waitCount++] = vkInit::semaphore_submit_info(VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT_KHR,
+			get_current_frame()._swapchainSemaphore);
+	}
+	if (_asyncCompute) {
+		waitInfos[waitCount++] = vkInit::semaphore_submit_info(ImageState::transfer_src().stage, _computeTimeline,
+			frame_timeline_value(uint64_t(_frameNumber)));
+	}
+	if (uploadWaitValue != 0) {
+		waitInfos[waitCount++] = vkInit::semaphore_submit_info(VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT,
+			_uploader.timeline(), uploadWaitValue);
+	}
+	if (batchWaitValue != 0) {
+		waitInfos[waitCount++] = vkInit::semaphore_submit_info(VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT,
+			_submitBatcher.timeline(), batchWaitValue);
+	}
+
+	VkSemaphoreSubmitInfo signalInfos[2] = {
+		vkInit::semaphore_submit_info(VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT, _frameTimeline,
+									  frame_timeline_value(uint64_t(_frameNumber))),
+		vkInit::semaphore_submit_info(VK_PIPELINE_STAGE_2_ALL_GRAPHICS_BIT,
+									  _config.headless ? VK_NULL_HANDLE : _presentSemaphores[swapchainImageIndex]),
+	};
+
+	// In headless non c'è nessuna immagine da attendere o da presentare, basta il semaforo timeline.
+	VkSubmitInfo2 submit = vkInit::submit_info(&cmdinfo, std::span(signalInfos, _config.headless ? 1 : 2),
+											   std::span(waitInfos, waitCount));
+
+	// Le allocazioni dell'arena fatte durante la registrazione devono arrivare alla GPU.
+	get_current_frame()._frameArena.flush(_allocator);
+
+	// Invia il command buffer alla queue e eseguilo.
+	auto submitStart = clock::now();
+	vkInit::VK_CHECK(vkQueueSubmit2(_graphicsQueue, 1, &submit, VK_NULL_HANDLE));
+	_lastFrameTimings.submitMs = ms(clock::now() - submitStart).count();
+
+	// gli oggetti ritirati fino a qui possono essere usati al massimo da questo frame.
+	_deletionQueue.close_batch(frame_timeline_value(uint64_t(_frameNumber)));
+
+	if (_config.headless) {
+		_lastFrameTimings.cpuMs = ms(clock::now() - frameStart).count();
+		_frameNumber++;
+		return true;
+	}
+
+
+	/*
+	* Prepara la presentazione
+	* 
+	* questo mette l'immagine che abbiamo renderizzato in una finestra visibile.
+	* vogliamo aspettare il semaforo di presentazione dell'immagine per questo.
+	* è necessario che i comandi di disegno abbiano finito di renderizzare l'immagine
+	* prima di mostrarla all'utente.
+	*/
+	VkPresentInfoKHR presentInfo = {};
+	presentInfo.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
+	presentInfo.pNext = nullptr;
+	presentInfo.pSwapchains = &_swapchain;
+	presentInfo.swapchainCount = 1;
+	presentInfo.pWaitSemaphores = &_presentSemaphores[swapchainImageIndex];
+	presentInfo.waitSemaphoreCount = 1;
+	presentInfo.pImageIndices = &swapchainImageIndex;
+
+	VkResult presentResult = vkQueuePresentKHR(_graphicsQueue, &presentInfo);
+
+	if (presentResult == VK_ERROR_OUT_OF_DATE_KHR || presentResult == VK_SUBOPTIMAL_KHR) {
+		_resizeRequested = true;
+	}
+	else {
+		vkInit::VK_CHECK(presentResult);
+	}
+
+	_lastFrameTimings.cpuMs = ms(clock::now() - frameStart).count();
+
+	//Incrementa il numero dei fotogrammi disegnati.
+	_frameNumber++;
+
+	return true;
+}
+
+/*
+* Funzione di disegno in background.
+* 
+* Richiama la compute shader impostata, 
+* dandogli un punto di aggancio alla nostra pipeline
+* 
+* poi dandogli i descriptor sets che abbiamo creato per quella shader
+* e immagine.
+* 
+* Infine, eseguiamo la pipeline con il comando dispatch. Il disegno viene
+* diviso di 16 su larghezza e 16 su altezza, poiché il gruppo di lavoro
+* è di 16x16 nella shader.
+* 
+*/
+void VulkanEngine::draw_background(VkCommandBuffer cmd)
+{
+	const PipelineEntry* effect = _pipelines.find(_backgroundEffect);
+
+	vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, effect->pipeline);
+
+	vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, effect->layout, 0, 1, 
+							&_bindless.set, 0, nullptr);
+
+	BackgroundPushConstants constants{};
+	constants.targetImage = _drawImageHandle;
+	constants.frameParameters = get_current_frame()._frameParameters;
+
+	vkCmdPushConstants(cmd, effect->layout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(constants), &constants);
+
+	vkCmdDispatch(cmd, std::ceil(_drawExtent.width / 16.0), std::ceil(_drawExtent.height / 16.0), 1);
+
+}
+
+/*
+* Scrive i parametri del frame nella sua arena. Lo slot è stato atteso all'inizio di draw(),
+* quindi la GPU non sta più leggendo l'arena.
+* Le scritture della CPU prima di vkQueueSubmit2 sono visibili alla GPU senza barriere,
+* basta il flush dell'arena se la memoria non è coerente.
+*/
+void VulkanEngine::update_frame_parameters()
+{
+	FrameParameters parameters{};
+	parameters.time = std::chrono::duration<float>(std::chrono::steady_clock::now() - _engineStart).count();
+	parameters.frameNumber = uint32_t(_frameNumber);
+	parameters.drawExtent[0] = _drawExtent.width;
+	parameters.drawExtent[1] = _drawExtent.height;
+
+	FrameData& frame = get_current_frame();
+
+	frame._frameParameters = frame._frameArena.push(parameters).address;
+	frame._frameArena.flush(_allocator);
+}
+
+/*
+* Registra e invia lo sfondo del frame corrente sulla queue compute.
+*
+* L'immagine di disegno è stata letta dalla copia del frame precedente sulla queue grafica:
+* attendiamo quel frame sul semaforo timeline, poi ne scartiamo il contenuto. Senza contenuto
+* da conservare non serve trasferirne la proprietà dalla grafica al compute.
+*
+* Al termine la rilasciamo alla famiglia grafica già nel layout della copia, e segnaliamo
+* _computeTimeline con il valore del frame. Le altre immagini restano sulla queue grafica.
+*/
+void VulkanEngine::submit_async_compute()
+{
+	FrameData& frame = get_current_frame();
+	VkCommandBuffer cmd = frame.computeCommandBuffer;
+
+	vkInit::VK_CHECK(vkResetCommandPool(_device, frame.computeCommandPool, 0));
+
+	VkCommandBufferBeginInfo beginInfo = vkInit::commandBufferBeginInfo(VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT);
+	vkInit::VK_CHECK(vkBeginCommandBuffer(cmd, &beginInfo));
+
+	frame._computeTimestamps.reset(cmd);
+
+	// Gli stage della queue grafica non valgono qui, la dipendenza dalla copia è data dal semaforo.
+	_drawImageState = ImageState::undefined();
+
+	RenderGraph graph;
+	uint32_t drawImage = graph.import_image("draw", _drawImage.image, _drawImageState);
+
+	graph.add_pass("background", { RenderGraph::write(drawImage, ImageState::compute_write()) },
+		[this](VkCommandBuffer cmd) { draw_background(cmd); });
+	graph.mark_output(drawImage);
+
+	graph.execute(cmd, frame._computeTimestamps, _config.fullBarriers);
+
+	ImageBarrierBatch barriers;
+	barriers.release(_drawImage.image, _drawImageState, ImageState::transfer_src().layout,
+					 _computeQueueFamily, _graphicsQueueFamily);
+	barriers.flush(cmd);
+
+	vkInit::VK_CHECK(vkEndCommandBuffer(cmd));
+
+	VkCommandBufferSubmitInfo cmdInfo = vkInit::command_buffer_submit_info(cmd);
+
+	// Il valore del frame precedente (_frameNumber) indica che la sua copia è terminata.
+	VkSemaphoreSubmitInfo waitInfo = vkInit::semaphore_submit_info(VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+		_frameTimeline, uint64_t(_frameNumber));
+	VkSemaphoreSubmitInfo signalInfo = vkInit::semaphore_submit_info(VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT,
+		_computeTimeline, frame_timeline_value(uint64_t(_frameNumber)));
+
+	VkSubmitInfo2 submit = vkInit::submit_info(&cmdInfo, &signalInfo, &waitInfo);
+
+	vkInit::VK_CHECK(vkQueueSubmit2(_computeQueue, 1, &submit, VK_NULL_HANDLE));
+}
+
+/*
+* Ogni MemoryMonitor::pollInterval fotogrammi (e a ogni stampa richiesta con --memory-log)
+* legge il budget della memoria GPU.
+*
+* Sopra memoryHighWater riduciamo _renderScale e ricreiamo subito l'immagine di disegno
+* alla nuova dimensione: quella vecchia viene liberata dalla deletion queue quando i frame
+* in volo sono terminati. Sotto memoryLowWater risaliamo di un passo alla volta, e l'immagine
+* viene ingrandita solo se la nuova porzione non ci sta più.
+* La distanza tra le due soglie evita di oscillare tra due scale ad ogni controllo.
+*/
+void VulkanEngine::update_memory_pressure()
+{
+	bool logRequested = _config.memoryLogInterval != 0 && _frameNumber % _config.memoryLogInterval == 0;
+
+	if (!logRequested && _frameNumber % MemoryMonitor::pollInterval != 0) {
+		return;
+	}
+
+	float pressure = _memoryMonitor.poll(uint32_t(_frameNumber));
+
+	if (logRequested) {
+		_memoryMonitor.log(uint64_t(_frameNumber));
+	}
+
+	if (!_config.memoryScaling) {
+		return;
+	}
+
+	if (pressure > memoryHighWater && _renderScale > minRenderScale) {
+		_renderScale = std::max(minRenderScale, _renderScale - renderScaleStep);
+
+		retire_draw_image();
+		create_draw_image(scaled_draw_extent());
+		register_draw_image();
+
+		fmt::print("Memoria GPU al {:.0f}% del budget, scala di disegno ridotta a {:.2f}\n",
+				   pressure * 100.0f, _renderScale);
+	}
+	else if (pressure < memoryLowWater && _renderScale < 1.0f) {
+		_renderScale = std::min(1.0f, _renderScale + renderScaleStep);
+
+		VkExtent3D capacity = _drawImage.imageExtent;
+		VkExtent2D required = scaled_draw_extent();
+
+		if (required.width > capacity.width || required.height > capacity.height) {
+			retire_draw_image();
+			create_draw_image({ std::max(required.width, capacity.width),
+								std::max(required.height, capacity.height) });
+			register_draw_image();
+		}
+
+		fmt::print("Memoria GPU al {:.0f}% del budget, scala di disegno aumentata a {:.2f}\n",
+				   pressure * 100.0f, _renderScale);
+	}
+}
+
+/*
+* Stampa i tempi GPU dell'ultimo frame completato ogni gpuLogInterval fotogrammi.
+*/
+void VulkanEngine::log_gpu_timings()
+{
+	if (_config.gpuLogInterval == 0 || _gpuTimings.empty() || _frameNumber % _config.gpuLogInterval != 0) {
+		return;
+	}
+
+	std::string line = fmt::format("GPU frame {}:", _frameNumber - _framesInFlight);
+	for (const GpuScopeTiming& timing : _gpuTimings) {
+		line += fmt::format(" {} {:.3f} ms", timing.name, timing.ms);
+	}
+	line += fmt::format(" | passaggi {} (scartati {}), barriere {} in {} chiamate",
+						_renderGraphStats.passes, _renderGraphStats.culledPasses,
+						_renderGraphStats.barriers, _renderGraphStats.barrierCalls);
+	fmt::print("{}\n", line);
+}
+
+/*
+* Funzione chiamata dopo ogni fotogramma disegnato.
+*
+* Passa i tempi del fotogramma al benchmark, se attivo, e ritorna true
+* quando il loop principale deve terminare: benchmark concluso oppure
+* raggiunto il numero di fotogrammi richiesto.
+*/
+bool VulkanEngine::end_frame(uint32_t& framesDrawn)
+{
+	framesDrawn++;
+
+	if (_config.benchmark()) {
+		_benchmark.record(_lastFrameTimings, _gpuTimings);
+		return _benchmark.finished();
+	}
+
+	return _config.frameCount != 0 && framesDrawn >= _config.frameCount;
+}
+
+/*
+* Loop principale.
+*
+* In headless non ci sono eventi della finestra: renderizziamo frameCount
+* fotogrammi il più velocemente possibile e stampiamo i fotogrammi al secondo.
+*
+* Alla fine del loop, se il benchmark è attivo ne scriviamo il resoconto.
+*/
+void VulkanEngine::run()
+{
+	if (_config.benchmark()) {
+		_benchmark.init(_config);
+	}
+
+	if (_config.headless) {
+		auto start = std::chrono::steady_clock::now();
+		uint32_t framesDrawn = 0;
+
+		// in headless non c'è una swapchain, quindi ogni frame viene inviato.
+		do {
+			draw();
+		} while (!end_frame(framesDrawn));
+
+		vkDeviceWaitIdle(_device);
+
+		std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+		fmt::print("Headless: {} fotogrammi in {:.3f} s ({:.1f} FPS)\n", framesDrawn, elapsed.count(),
+				   framesDrawn / elapsed.count());
+	}
+	else {
+		run_windowed();
+	}
+
+	if (_config.benchmark()) {
+		_benchmark.print_summary();
+		_benchmark.write_report(_config.benchmarkOutput);
+	}
+
+	if (!_config.memoryDumpPath.empty()) {
+		_memoryMonitor.dump_json(_config.memoryDumpPath);
+	}
+}
+
+void VulkanEngine::run_windowed()
+{
+	SDL_Event e;
+	bool bQuit = false;
+	uint32_t framesDrawn = 0;
+
+	// main loop
+	while (!bQuit) {
+		while (SDL_PollEvent(&e) != 0) {
+			if (e.type == SDL_QUIT)
+				bQuit = true;
+
+			if (e.type == SDL_WINDOWEVENT) {
+				if (e.window.event == SDL_WINDOWEVENT_MINIMIZED) {
+					stop_rendering = true;
+				}
+				if (e.window.event == SDL_WINDOWEVENT_RESTORED) {
+					stop_rendering = false;
+				}
+				if (e.window.event == SDL_WINDOWEVENT_SIZE_CHANGED) {
+					_resizeRequested = true;
+				}
+			}
+
+			// Le frecce sinistra e destra cambiano l'effetto di sfondo.
+			if (e.type == SDL_KEYDOWN) {
+				if (e.key.keysym.sym == SDLK_RIGHT) {
+					cycle_background_effect(1);
+				}
+				if (e.key.keysym.sym == SDLK_LEFT) {
+					cycle_background_effect(-1);
+				}
+				// P cambia la politica di presentazione, ricostruendo la swapchain.
+				if (e.key.keysym.sym == SDLK_p) {
+					cycle_present_policy();
+				}
+				// M salva le statistiche della memoria GPU.
+				if (e.key.keysym.sym == SDLK_m) {
+					_memoryMonitor.dump_json(_config.memoryDumpPath.empty() ? "memory_stats.json" : _config.memoryDumpPath);
+				}
+			}
+		}
+
+		// Non renderizzare se la finestra è minimizzata.
+		if (stop_rendering) {
+			// Rallenta la velocità del thread.
+			std::this_thread::sleep_for(std::chrono::milliseconds(100));
+			continue;
+		}
+
+		// un frame non inviato (swapchain da ricostruire) non conta per --frames e per il benchmark.
+		if (draw() && end_frame(framesDrawn)) {
+			bQuit = true;
+		}
+	}
+}
@@ -0,0 +1,155 @@
+#include "../include/vk_files.hpp"
+#include <fstream>
+#include <utility>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MappedFile& MappedFile::operator=(MappedFile&& other) noexcept
+{
+	if (this != &other) {
+		close();
+
+		data = std::exchange(other.data, nullptr);
+		size = std::exchange(other.size, 0);
+#ifdef _WIN32
+		fileHandle = std::exchange(other.fileHandle, nullptr);
+		mappingHandle = std::exchange(other.mappingHandle, nullptr);
+#endif
+	}
+
+	return *this;
+}
+
+/*
+* La dimensione viene letta una volta sola: se il file cambia durante la lettura
+* otteniamo meno byte del previsto e ritorniamo false, senza errori del sistema.
+*/
+bool vkutil::read_file_words(const std::string& path, std::vector<uint32_t>& out)
+{
+	std::ifstream file(path, std::ios::ate | std::ios::binary);
+
+	if (!file.is_open()) {
+		return false;
+	}
+
+	std::streamoff size = file.tellg();
+
+	if (size <= 0 || size % std::streamoff(sizeof(uint32_t)) != 0) {
+		return false;
+	}
+
+	out.resize(size_t(size) / sizeof(uint32_t));
+	file.seekg(0);
+	file.read(reinterpret_cast<char*>(out.data()), size);
+
+	return bool(file);
+}
+
+#ifdef _WIN32
+
+bool MappedFile::open(const std::string& path)
+{
+	close();
+
+	HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+							  FILE_ATTRIBUTE_NORMAL, nullptr);
+
+	if (file == INVALID_HANDLE_VALUE) {
+		return false;
+	}
+
+	LARGE_INTEGER fileSize;
+	if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0) {
+		CloseHandle(file);
+		return false;
+	}
+
+	HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (mapping == nullptr) {
+		CloseHandle(file);
+		return false;
+	}
+
+	void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+	if (view == nullptr) {
+		CloseHandle(mapping);
+		CloseHandle(file);
+		return false;
+	}
+
+	fileHandle = file;
+	mappingHandle = mapping;
+	data = static_cast<const std::byte*>(view);
+	size = size_t(fileSize.QuadPart);
+
+	return true;
+}
+
+void MappedFile::close()
+{
+	if (data != nullptr) {
+		UnmapViewOfFile(data);
+		CloseHandle(mappingHandle);
+		CloseHandle(fileHandle);
+	}
+
+	data = nullptr;
+	size = 0;
+	fileHandle = nullptr;
+	mappingHandle = nullptr;
+}
+
+#else
+
+/*
+* Dopo mmap il file descriptor si può chiudere subito, la mappatura resta valida
+* fino a munmap.
+*/
+bool MappedFile::open(const std::string& path)
+{
+	close();
+
+	int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+
+	if (fd < 0) {
+		return false;
+	}
+
+	struct stat info;
+	if (fstat(fd, &info) != 0 || info.st_size == 0) {
+		::close(fd);
+		return false;
+	}
+
+	void* view = mmap(nullptr, size_t(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+	::close(fd);
+
+	if (view == MAP_FAILED) {
+		return false;
+	}
+
+	data = static_cast<const std::byte*>(view);
+	size = size_t(info.st_size);
+
+	return true;
+}
+
+void MappedFile::close()
+{
+	if (data != nullptr) {
+		munmap(const_cast<std::byte*>(data), size);
+	}
+
+	data = nullptr;
+	size = 0;
+}
+
+#endif
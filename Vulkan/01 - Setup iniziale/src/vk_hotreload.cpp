@@ -0,0 +1,141 @@
+#include "../include/vk_hotreload.hpp"
+#include <algorithm>
+#include <filesystem>
+#include <unordered_map>
+#include <fmt/core.h>
+
+#ifdef __linux__
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+void ShaderWatcher::start(const std::string& directory)
+{
+	_directory = directory;
+	_running = true;
+	_thread = std::thread(&ShaderWatcher::watch_loop, this);
+}
+
+void ShaderWatcher::stop()
+{
+	_running = false;
+
+	if (_thread.joinable()) {
+		_thread.join();
+	}
+}
+
+std::vector<ShaderChange> ShaderWatcher::poll_changes()
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+
+	std::vector<ShaderChange> changes;
+	changes.swap(_changes);
+
+	return changes;
+}
+
+/*
+* Registra una modifica, solo per i file .spv. Se il file è già in attesa
+* teniamo l'istante della prima modifica, da cui misuriamo la latenza del ricaricamento.
+*/
+void ShaderWatcher::push_change(const std::string& path)
+{
+	if (std::filesystem::path(path).extension() != ".spv") {
+		return;
+	}
+
+	std::lock_guard<std::mutex> lock(_mutex);
+
+	auto existing = std::find_if(_changes.begin(), _changes.end(),
+		[&path](const ShaderChange& change) { return change.path == path; });
+
+	if (existing == _changes.end()) {
+		_changes.push_back({ path, std::chrono::steady_clock::now() });
+	}
+}
+
+#ifdef __linux__
+
+/*
+* Il file descriptor di inotify è non bloccante e lo attendiamo con poll() per al massimo
+* 100 ms, cosi il thread si accorge in fretta della richiesta di stop.
+*/
+void ShaderWatcher::watch_loop()
+{
+	int fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+
+	if (fd < 0 || inotify_add_watch(fd, _directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO) < 0) {
+		fmt::print("Impossibile osservare la cartella {}, hot-reload disattivato\n", _directory);
+		if (fd >= 0) {
+			close(fd);
+		}
+		return;
+	}
+
+	alignas(inotify_event) char buffer[4096];
+
+	while (_running) {
+		pollfd pfd{ fd, POLLIN, 0 };
+
+		if (poll(&pfd, 1, 100) <= 0) {
+			continue;
+		}
+
+		ssize_t length = read(fd, buffer, sizeof(buffer));
+
+		for (ssize_t offset = 0; offset < length;) {
+			const inotify_event* event = reinterpret_cast<const inotify_event*>(buffer + offset);
+
+			if (event->len > 0) {
+				push_change((std::filesystem::path(_directory) / event->name).string());
+			}
+
+			offset += sizeof(inotify_event) + event->len;
+		}
+	}
+
+	close(fd);
+}
+
+#else
+
+/*
+* Senza inotify confrontiamo la data di ultima modifica di ogni file .spv
+* con quella vista al controllo precedente.
+*/
+void ShaderWatcher::watch_loop()
+{
+	namespace fs = std::filesystem;
+
+	std::unordered_map<std::string, fs::file_time_type> lastWrite;
+	bool firstScan = true;
+
+	while (_running) {
+		std::error_code error;
+
+		for (const auto& entry : fs::directory_iterator(_directory, error)) {
+			if (!entry.is_regular_file()) {
+				continue;
+			}
+
+			std::string path = entry.path().string();
+			fs::file_time_type writeTime = entry.last_write_time(error);
+
+			auto it = lastWrite.find(path);
+			if (it == lastWrite.end() || it->second != writeTime) {
+				lastWrite[path] = writeTime;
+
+				if (!firstScan) {
+					push_change(path);
+				}
+			}
+		}
+
+		firstScan = false;
+		std::this_thread::sleep_for(std::chrono::milliseconds(250));
+	}
+}
+
+#endif
@@ -1,75 +1,220 @@
-#include "../include/vk_images.hpp"
-
-void vkutil::transition_image(VkCommandBuffer cmd, VkImage image, 
-                              VkImageLayout currentLayout, VkImageLayout newLayout)
-{
-    VkImageMemoryBarrier2 imageBarrier{ .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2 };
-    imageBarrier.pNext = nullptr;
-
-    imageBarrier.srcStageMask = VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT;
-    imageBarrier.srcAccessMask = VK_ACCESS_2_MEMORY_WRITE_BIT;
-    imageBarrier.dstStageMask = VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT;
-    imageBarrier.dstAccessMask = VK_ACCESS_2_MEMORY_WRITE_BIT | VK_ACCESS_2_MEMORY_READ_BIT;
-
-    imageBarrier.oldLayout = currentLayout;
-    imageBarrier.newLayout = newLayout;
-
-    VkImageAspectFlags aspectMask = (newLayout == VK_IMAGE_LAYOUT_DEPTH_ATTACHMENT_OPTIMAL) ? VK_IMAGE_ASPECT_DEPTH_BIT : VK_IMAGE_ASPECT_COLOR_BIT;
-    imageBarrier.subresourceRange = image_subresource_range(aspectMask);
-    imageBarrier.image = image;
-
-    VkDependencyInfo depInfo{};
-    depInfo.sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO;
-    depInfo.pNext = nullptr;
-
-    depInfo.imageMemoryBarrierCount = 1;
-    depInfo.pImageMemoryBarriers = &imageBarrier;
-
-    vkCmdPipelineBarrier2(cmd, &depInfo);
-}
-
-VkImageSubresourceRange vkutil::image_subresource_range(VkImageAspectFlags aspectMask)
-{
-    VkImageSubresourceRange subImage{};
-    subImage.aspectMask = aspectMask;
-    subImage.baseMipLevel = 0;
-    subImage.levelCount = VK_REMAINING_MIP_LEVELS;
-    subImage.baseArrayLayer = 0;
-    subImage.layerCount = VK_REMAINING_ARRAY_LAYERS;
-    return subImage;
-}
-
-void vkutil::copy_image_to_image(VkCommandBuffer cmd, VkImage source, VkImage destination, 
-                                 VkExtent2D srcSize, VkExtent2D dstSize)
-{
-    VkImageBlit2 blitRegion{ .sType = VK_STRUCTURE_TYPE_IMAGE_BLIT_2, .pNext = nullptr };
-
-    blitRegion.srcOffsets[1].x = srcSize.width;
-    blitRegion.srcOffsets[1].y = srcSize.height;
-    blitRegion.srcOffsets[1].z = 1;
-
-    blitRegion.dstOffsets[1].x = dstSize.width;
-    blitRegion.dstOffsets[1].y = dstSize.height;
-    blitRegion.dstOffsets[1].z = 1;
-
-    blitRegion.srcSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-    blitRegion.srcSubresource.baseArrayLayer = 0;
-    blitRegion.srcSubresource.layerCount = 1;
-    blitRegion.srcSubresource.mipLevel = 0;
-
-    blitRegion.dstSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-    blitRegion.dstSubresource.baseArrayLayer = 0;
-    blitRegion.dstSubresource.layerCount = 1;
-    blitRegion.dstSubresource.mipLevel = 0;
-
-    VkBlitImageInfo2 blitInfo{ .sType = VK_STRUCTURE_TYPE_BLIT_IMAGE_INFO_2, .pNext = nullptr };
-    blitInfo.dstImage = destination;
-    blitInfo.dstImageLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
-    blitInfo.srcImage = source;
-    blitInfo.srcImageLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
-    blitInfo.filter = VK_FILTER_LINEAR;
-    blitInfo.regionCount = 1;
-    blitInfo.pRegions = &blitRegion;
-
-    vkCmdBlitImage2(cmd, &blitInfo);
-}
+#include "../include/vk_images.hpp"
+
+// Gli accessi che scrivono memoria, per capire se una barriera senza cambio di layout serve.
+static constexpr VkAccessFlags2 writeAccessMask = VK_ACCESS_2_SHADER_WRITE_BIT | VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT |
+                                                  VK_ACCESS_2_COLOR_ATTACHMENT_WRITE_BIT |
+                                                  VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT |
+                                                  VK_ACCESS_2_TRANSFER_WRITE_BIT | VK_ACCESS_2_HOST_WRITE_BIT |
+                                                  VK_ACCESS_2_MEMORY_WRITE_BIT;
+
+void ImageBarrierBatch::transition(VkImage image, ImageState& state, const ImageState& next, VkImageAspectFlags aspectMask)
+{
+    bool writes = ((state.access | next.access) & writeAccessMask) != 0;
+
+    if (state.layout == next.layout && !writes && !fullBarriers) {
+        state.stage |= next.stage;
+        state.access |= next.access;
+        return;
+    }
+
+    VkImageMemoryBarrier2 imageBarrier{ .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2 };
+    imageBarrier.pNext = nullptr;
+
+    if (fullBarriers) {
+        imageBarrier.srcStageMask = VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT;
+        imageBarrier.srcAccessMask = VK_ACCESS_2_MEMORY_WRITE_BIT;
+        imageBarrier.dstStageMask = VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT;
+        imageBarrier.dstAccessMask = VK_ACCESS_2_MEMORY_WRITE_BIT | VK_ACCESS_2_MEMORY_READ_BIT;
+    }
+    else {
+        // Le sole letture precedenti non devono essere rese visibili: basta la dipendenza di esecuzione.
+        imageBarrier.srcStageMask = state.stage;
+        imageBarrier.srcAccessMask = state.access & writeAccessMask;
+        imageBarrier.dstStageMask = next.stage;
+        imageBarrier.dstAccessMask = next.access;
+    }
+
+    imageBarrier.oldLayout = state.layout;
+    imageBarrier.newLayout = next.layout;
+    imageBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    imageBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+
+    imageBarrier.subresourceRange = vkutil::image_subresource_range(aspectMask);
+    imageBarrier.image = image;
+
+    barriers.push_back(imageBarrier);
+    state = next;
+}
+
+/*
+* Metà del trasferimento registrata dalla queue che cede l'immagine: rende disponibili
+* le scritture precedenti, lo stage di destinazione non ha senso su questa queue.
+*/
+void ImageBarrierBatch::release(VkImage image, const ImageState& state, VkImageLayout newLayout,
+                                uint32_t srcQueueFamily, uint32_t dstQueueFamily, VkImageAspectFlags aspectMask)
+{
+    VkImageMemoryBarrier2 imageBarrier{ .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2 };
+    imageBarrier.pNext = nullptr;
+
+    imageBarrier.srcStageMask = state.stage;
+    imageBarrier.srcAccessMask = state.access & writeAccessMask;
+    imageBarrier.dstStageMask = VK_PIPELINE_STAGE_2_NONE;
+    imageBarrier.dstAccessMask = VK_ACCESS_2_NONE;
+
+    imageBarrier.oldLayout = state.layout;
+    imageBarrier.newLayout = newLayout;
+    imageBarrier.srcQueueFamilyIndex = srcQueueFamily;
+    imageBarrier.dstQueueFamilyIndex = dstQueueFamily;
+
+    imageBarrier.subresourceRange = vkutil::image_subresource_range(aspectMask);
+    imageBarrier.image = image;
+
+    barriers.push_back(imageBarrier);
+}
+
+/*
+* Metà del trasferimento registrata dalla queue che riceve l'immagine: l'attesa del lavoro
+* dell'altra queue è data dal semaforo, qui serve solo rendere l'immagine visibile a chi la userà.
+*/
+void ImageBarrierBatch::acquire(VkImage image, ImageState& state, const ImageState& next,
+                                uint32_t srcQueueFamily, uint32_t dstQueueFamily, VkImageAspectFlags aspectMask)
+{
+    VkImageMemoryBarrier2 imageBarrier{ .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2 };
+    imageBarrier.pNext = nullptr;
+
+    imageBarrier.srcStageMask = VK_PIPELINE_STAGE_2_NONE;
+    imageBarrier.srcAccessMask = VK_ACCESS_2_NONE;
+    imageBarrier.dstStageMask = next.stage;
+    imageBarrier.dstAccessMask = next.access;
+
+    imageBarrier.oldLayout = state.layout;
+    imageBarrier.newLayout = next.layout;
+    imageBarrier.srcQueueFamilyIndex = srcQueueFamily;
+    imageBarrier.dstQueueFamilyIndex = dstQueueFamily;
+
+    imageBarrier.subresourceRange = vkutil::image_subresource_range(aspectMask);
+    imageBarrier.image = image;
+
+    barriers.push_back(imageBarrier);
+    state = next;
+}
+
+/*
+* Invia tutte le barriere raccolte in una sola chiamata. Senza barriere non fa nulla.
+*/
+void ImageBarrierBatch::flush(VkCommandBuffer cmd)
+{
+    if (barriers.empty()) {
+        return;
+    }
+
+    VkDependencyInfo depInfo{};
+    depInfo.sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO;
+    depInfo.pNext = nullptr;
+
+    depInfo.imageMemoryBarrierCount = uint32_t(barriers.size());
+    depInfo.pImageMemoryBarriers = barriers.data();
+
+    vkCmdPipelineBarrier2(cmd, &depInfo);
+
+    barriers.clear();
+}
+
+/*
+* Transizione singola con barriera completa (ALL_COMMANDS), semplice ma lenta:
+* per il disegno dei frame usa ImageBarrierBatch.
+*/
+void vkutil::transition_image(VkCommandBuffer cmd, VkImage image, 
+                              VkImageLayout currentLayout, VkImageLayout newLayout)
+{
+    VkImageMemoryBarrier2 imageBarrier{ .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2 };
+    imageBarrier.pNext = nullptr;
+
+    imageBarrier.srcStageMask = VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT;
+    imageBarrier.srcAccessMask = VK_ACCESS_2_MEMORY_WRITE_BIT;
+    imageBarrier.dstStageMask = VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT;
+    imageBarrier.dstAccessMask = VK_ACCESS_2_MEMORY_WRITE_BIT | VK_ACCESS_2_MEMORY_READ_BIT;
+
+    imageBarrier.oldLayout = currentLayout;
+    imageBarrier.newLayout = newLayout;
+
+    VkImageAspectFlags aspectMask = (newLayout == VK_IMAGE_LAYOUT_DEPTH_ATTACHMENT_OPTIMAL) ? VK_IMAGE_ASPECT_DEPTH_BIT : VK_IMAGE_ASPECT_COLOR_BIT;
+    imageBarrier.subresourceRange = image_subresource_range(aspectMask);
+    imageBarrier.image = image;
+
+    VkDependencyInfo depInfo{};
+    depInfo.sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO;
+    depInfo.pNext = nullptr;
+
+    depInfo.imageMemoryBarrierCount = 1;
+    depInfo.pImageMemoryBarriers = &imageBarrier;
+
+    vkCmdPipelineBarrier2(cmd, &depInfo);
+}
+
+VkImageSubresourceRange vkutil::image_subresource_range(VkImageAspectFlags aspectMask)
+{
+    VkImageSubresourceRange subImage{};
+    subImage.aspectMask = aspectMask;
+    subImage.baseMipLevel = 0;
+    subImage.levelCount = VK_REMAINING_MIP_LEVELS;
+    subImage.baseArrayLayer = 0;
+    subImage.layerCount = VK_REMAINING_ARRAY_LAYERS;
+    return subImage;
+}
+
+void vkutil::copy_image_to_image(VkCommandBuffer cmd, VkImage source, VkImage destination, 
+                                 VkExtent2D srcSize, VkExtent2D dstSize)
+{
+    VkImageBlit2 blitRegion{ .sType = VK_STRUCTURE_TYPE_IMAGE_BLIT_2, .pNext = nullptr };
+
+    blitRegion.srcOffsets[1].x = srcSize.width;
+    blitRegion.srcOffsets[1].y = srcSize.height;
+    blitRegion.srcOffsets[1].z = 1;
+
+    blitRegion.dstOffsets[1].x = dstSize.width;
+    blitRegion.dstOffsets[1].y = dstSize.height;
+    blitRegion.dstOffsets[1].z = 1;
+
+    blitRegion.srcSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    blitRegion.srcSubresource.baseArrayLayer = 0;
+    blitRegion.srcSubresource.layerCount = 1;
+    blitRegion.srcSubresource.mipLevel = 0;
+
+    blitRegion.dstSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    blitRegion.dstSubresource.baseArrayLayer = 0;
+    blitRegion.dstSubresource.layerCount = 1;
+    blitRegion.dstSubresource.mipLevel = 0;
+
+    VkBlitImageInfo2 blitInfo{ .sType = VK_STRUCTURE_TYPE_BLIT_IMAGE_INFO_2, .pNext = nullptr };
+    blitInfo.dstImage = destination;
+    blitInfo.dstImageLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+    blitInfo.srcImage = source;
+    blitInfo.srcImageLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+    blitInfo.filter = VK_FILTER_LINEAR;
+    blitInfo.regionCount = 1;
+    blitInfo.pRegions = &blitRegion;
+
+    vkCmdBlitImage2(cmd, &blitInfo);
+}
+
+/*
+* Copia un'immagine a colori (mip 0, layer 0) in un buffer, con le righe
+* compatte una dopo l'altra, cosi da poterla leggere dalla CPU.
+* L'immagine deve essere nel layout TRANSFER_SRC_OPTIMAL.
+*/
+void vkutil::copy_image_to_buffer(VkCommandBuffer cmd, VkImage source, VkBuffer destination, VkExtent2D size)
+{
+    VkBufferImageCopy copyRegion{};
+    copyRegion.bufferOffset = 0;
+    copyRegion.bufferRowLength = 0;
+    copyRegion.bufferImageHeight = 0;
+
+    copyRegion.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    copyRegion.imageSubresource.mipLevel = 0;
+    copyRegion.imageSubresource.baseArrayLayer = 0;
+    copyRegion.imageSubresource.layerCount = 1;
+    copyRegion.imageExtent = { size.width, size.height, 1 };
+
+    vkCmdCopyImageToBuffer(cmd, source, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, destination, 1, &copyRegion);
+}
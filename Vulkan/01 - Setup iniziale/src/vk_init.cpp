@@ -1,144 +1,220 @@
-/**
- * @file vk_engine.cpp
- * @author Fabxx
- * @brief Classe che si occupa delle funzionalità di inizializzazione dell'engine.
- * @version 0.1
- * @date 2025-05-02
- * 
- * @copyright Copyright (c) 2025
- * 
- */
-
-#pragma once
-
-#include "../include/vk_init.hpp"
-#include <iostream>
-#include <fstream>
-
-VkFenceCreateInfo vkInit::fenceInfo(VkFenceCreateFlagBits flags) {
-	VkFenceCreateInfo fenceInfo = {};
-	fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
-	fenceInfo.pNext = nullptr;
-	fenceInfo.flags = flags;
-	return fenceInfo;
-}
-
-VkSemaphoreCreateInfo vkInit::semaphoreInfo(VkSemaphoreCreateFlags flags) {
-	VkSemaphoreCreateInfo semaphoreInfo = {};
-	semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
-	semaphoreInfo.pNext = nullptr;
-	semaphoreInfo.flags = flags;
-	return semaphoreInfo;
-}
-
-VkCommandBufferBeginInfo vkInit::commandBufferBeginInfo(VkCommandBufferUsageFlagBits flags) {
-	VkCommandBufferBeginInfo cmdBeginInfo = {};
-	cmdBeginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
-	cmdBeginInfo.pNext = nullptr;
-	cmdBeginInfo.pInheritanceInfo = nullptr;
-	cmdBeginInfo.flags = flags;
-	return cmdBeginInfo;
-}
-
-VkSemaphoreSubmitInfo vkInit::semaphore_submit_info(VkPipelineStageFlags2 stageMask, VkSemaphore semaphore)
-{
-	VkSemaphoreSubmitInfo submitInfo{};
-	submitInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_SUBMIT_INFO;
-	submitInfo.pNext = nullptr;
-	submitInfo.semaphore = semaphore;
-	submitInfo.stageMask = stageMask;
-	submitInfo.deviceIndex = 0;
-	submitInfo.value = 1;
-
-	return submitInfo;
-}
-
-VkCommandBufferSubmitInfo vkInit::command_buffer_submit_info(VkCommandBuffer cmd)
-{
-	VkCommandBufferSubmitInfo info{};
-	info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_SUBMIT_INFO;
-	info.pNext = nullptr;
-	info.commandBuffer = cmd;
-	info.deviceMask = 0;
-
-	return info;
-}
-
-VkSubmitInfo2 vkInit::submit_info(VkCommandBufferSubmitInfo* cmd, VkSemaphoreSubmitInfo* signalSemaphoreInfo,
-								  VkSemaphoreSubmitInfo* waitSemaphoreInfo)
-{
-	VkSubmitInfo2 info = {};
-	info.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO_2;
-	info.pNext = nullptr;
-
-	info.waitSemaphoreInfoCount = waitSemaphoreInfo == nullptr ? 0 : 1;
-	info.pWaitSemaphoreInfos = waitSemaphoreInfo;
-
-	info.signalSemaphoreInfoCount = signalSemaphoreInfo == nullptr ? 0 : 1;
-	info.pSignalSemaphoreInfos = signalSemaphoreInfo;
-
-	info.commandBufferInfoCount = 1;
-	info.pCommandBufferInfos = cmd;
-
-	return info;
-}
-
-VkImageCreateInfo vkInit::image_create_info(VkFormat format, VkImageUsageFlags usageFlags, VkExtent3D extent)
-{
-	VkImageCreateInfo info = {};
-	info.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
-	info.pNext = nullptr;
-
-	info.imageType = VK_IMAGE_TYPE_2D;
-
-	info.format = format;
-	info.extent = extent;
-
-	info.mipLevels = 1;
-	info.arrayLayers = 1;
-
-	/*
-	* Per Multi sampling anti aliasing MSAA, noi non lo useremo, quindi lo mettiamo il campionamento a 
-	* 1 campione per pixel.
-	*/
-	info.samples = VK_SAMPLE_COUNT_1_BIT;
-
-	/*
-	* optimal tiling, l'immagine è immagazzinata nel miglior formato per la GPU
-	* Se vogliamo leggere i dati dell'immagine dalla CPU, dovremmo usare il tiling LINEAR, 
-	* che trasforma i dati della GPU in un semplice array 2D.
-	*/
-	
-	info.tiling = VK_IMAGE_TILING_OPTIMAL;
-	info.usage = usageFlags;
-
-	return info;
-}
-
-VkImageViewCreateInfo vkInit::imageview_create_info(VkFormat format, VkImage image, VkImageAspectFlags aspectFlags)
-{
-	// build a image-view for the depth image to use for rendering
-	VkImageViewCreateInfo info = {};
-	info.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
-	info.pNext = nullptr;
-
-	info.viewType = VK_IMAGE_VIEW_TYPE_2D;
-	info.image = image;
-	info.format = format;
-	info.subresourceRange.baseMipLevel = 0;
-	info.subresourceRange.levelCount = 1;
-	info.subresourceRange.baseArrayLayer = 0;
-	info.subresourceRange.layerCount = 1;
-	info.subresourceRange.aspectMask = aspectFlags;
-
-	return info;
-}
-
-
-VkResult vkInit::VK_CHECK(VkResult x) {
-	if (x != VK_SUCCESS) {
-		std::cerr << "Error occurred: " << x << "\n";
-		abort();
-	}
-	return x;
+/**
+ * @file vk_engine.cpp
+ * @author Fabxx
+ * @brief Classe che si occupa delle funzionalità di inizializzazione dell'engine.
+ * @version 0.1
+ * @date 2025-05-02
+ * 
+ * @copyright Copyright (c) 2025
+ * 
+ */
+
+#pragma once
+
+#include "../include/vk_init.hpp"
+#include <iostream>
+#include <fstream>
+
+VkFenceCreateInfo vkInit::fenceInfo(VkFenceCreateFlagBits flags) {
+	VkFenceCreateInfo fenceInfo = {};
+	fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+	fenceInfo.pNext = nullptr;
+	fenceInfo.flags = flags;
+	return fenceInfo;
+}
+
+VkSemaphoreCreateInfo vkInit::semaphoreInfo(VkSemaphoreCreateFlags flags) {
+	VkSemaphoreCreateInfo semaphoreInfo = {};
+	semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+	semaphoreInfo.pNext = nullptr;
+	semaphoreInfo.flags = flags;
+	return semaphoreInfo;
+}
+
+VkCommandBufferBeginInfo vkInit::commandBufferBeginInfo(VkCommandBufferUsageFlagBits flags) {
+	VkCommandBufferBeginInfo cmdBeginInfo = {};
+	cmdBeginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+	cmdBeginInfo.pNext = nullptr;
+	cmdBeginInfo.pInheritanceInfo = nullptr;
+	cmdBeginInfo.flags = flags;
+	return cmdBeginInfo;
+}
+
+VkCommandPoolCreateInfo vkInit::command_pool_create_info(uint32_t queueFamilyIndex, VkCommandPoolCreateFlags flags)
+{
+	VkCommandPoolCreateInfo info = {};
+	info.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+	info.pNext = nullptr;
+	info.flags = flags;
+	info.queueFamilyIndex = queueFamilyIndex;
+	return info;
+}
+
+VkCommandBufferAllocateInfo vkInit::command_buffer_allocate_info(VkCommandPool pool, uint32_t count, VkCommandBufferLevel level)
+{
+	VkCommandBufferAllocateInfo info = {};
+	info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+	info.pNext = nullptr;
+	info.commandPool = pool;
+	info.commandBufferCount = count;
+	info.level = level;
+	return info;
+}
+
+/*
+* Ereditarietà di un command buffer secondario registrato fuori da un render pass:
+* nessun render pass, subpass o framebuffer da ereditare.
+*/
+VkCommandBufferInheritanceInfo vkInit::command_buffer_inheritance_info()
+{
+	VkCommandBufferInheritanceInfo info = {};
+	info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+	info.pNext = nullptr;
+	info.renderPass = VK_NULL_HANDLE;
+	info.subpass = 0;
+	info.framebuffer = VK_NULL_HANDLE;
+	return info;
+}
+
+/*
+* Da concatenare (pNext) a VkSemaphoreCreateInfo per creare un semaforo timeline:
+* contiene un contatore a 64 bit che la GPU e la CPU possono attendere e segnalare
+* con valori sempre crescenti.
+*/
+VkSemaphoreTypeCreateInfo vkInit::timeline_semaphore_info(uint64_t initialValue)
+{
+	VkSemaphoreTypeCreateInfo info = {};
+	info.sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO;
+	info.pNext = nullptr;
+	info.semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE;
+	info.initialValue = initialValue;
+
+	return info;
+}
+
+/*
+* value è il valore da attendere o segnalare per un semaforo timeline,
+* per i semafori binari viene ignorato.
+*/
+VkSemaphoreSubmitInfo vkInit::semaphore_submit_info(VkPipelineStageFlags2 stageMask, VkSemaphore semaphore, uint64_t value)
+{
+	VkSemaphoreSubmitInfo submitInfo{};
+	submitInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_SUBMIT_INFO;
+	submitInfo.pNext = nullptr;
+	submitInfo.semaphore = semaphore;
+	submitInfo.stageMask = stageMask;
+	submitInfo.deviceIndex = 0;
+	submitInfo.value = value;
+
+	return submitInfo;
+}
+
+VkCommandBufferSubmitInfo vkInit::command_buffer_submit_info(VkCommandBuffer cmd)
+{
+	VkCommandBufferSubmitInfo info{};
+	info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_SUBMIT_INFO;
+	info.pNext = nullptr;
+	info.commandBuffer = cmd;
+	info.deviceMask = 0;
+
+	return info;
+}
+
+VkSubmitInfo2 vkInit::submit_info(VkCommandBufferSubmitInfo* cmd, VkSemaphoreSubmitInfo* signalSemaphoreInfo,
+								  VkSemaphoreSubmitInfo* waitSemaphoreInfo)
+{
+	VkSubmitInfo2 info = {};
+	info.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO_2;
+	info.pNext = nullptr;
+
+	info.waitSemaphoreInfoCount = waitSemaphoreInfo == nullptr ? 0 : 1;
+	info.pWaitSemaphoreInfos = waitSemaphoreInfo;
+
+	info.signalSemaphoreInfoCount = signalSemaphoreInfo == nullptr ? 0 : 1;
+	info.pSignalSemaphoreInfos = signalSemaphoreInfo;
+
+	info.commandBufferInfoCount = 1;
+	info.pCommandBufferInfos = cmd;
+
+	return info;
+}
+
+// Come sopra, ma con più semafori da attendere e segnalare.
+VkSubmitInfo2 vkInit::submit_info(VkCommandBufferSubmitInfo* cmd, std::span<const VkSemaphoreSubmitInfo> signalSemaphoreInfos,
+								  std::span<const VkSemaphoreSubmitInfo> waitSemaphoreInfos)
+{
+	VkSubmitInfo2 info = {};
+	info.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO_2;
+	info.pNext = nullptr;
+
+	info.waitSemaphoreInfoCount = uint32_t(waitSemaphoreInfos.size());
+	info.pWaitSemaphoreInfos = waitSemaphoreInfos.data();
+
+	info.signalSemaphoreInfoCount = uint32_t(signalSemaphoreInfos.size());
+	info.pSignalSemaphoreInfos = signalSemaphoreInfos.data();
+
+	info.commandBufferInfoCount = 1;
+	info.pCommandBufferInfos = cmd;
+
+	return info;
+}
+
+VkImageCreateInfo vkInit::image_create_info(VkFormat format, VkImageUsageFlags usageFlags, VkExtent3D extent)
+{
+	VkImageCreateInfo info = {};
+	info.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+	info.pNext = nullptr;
+
+	info.imageType = VK_IMAGE_TYPE_2D;
+
+	info.format = format;
+	info.extent = extent;
+
+	info.mipLevels = 1;
+	info.arrayLayers = 1;
+
+	/*
+	* Per Multi sampling anti aliasing MSAA, noi non lo useremo, quindi lo mettiamo il campionamento a 
+	* 1 campione per pixel.
+	*/
+	info.samples = VK_SAMPLE_COUNT_1_BIT;
+
+	/*
+	* optimal tiling, l'immagine è immagazzinata nel miglior formato per la GPU
+	* Se vogliamo leggere i dati dell'immagine dalla CPU, dovremmo usare il tiling LINEAR, 
+	* che trasforma i dati della GPU in un semplice array 2D.
+	*/
+	
+	info.tiling = VK_IMAGE_TILING_OPTIMAL;
+	info.usage = usageFlags;
+
+	return info;
+}
+
+VkImageViewCreateInfo vkInit::imageview_create_info(VkFormat format, VkImage image, VkImageAspectFlags aspectFlags)
+{
+	// build a image-view for the depth image to use for rendering
+	VkImageViewCreateInfo info = {};
+	info.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+	info.pNext = nullptr;
+
+	info.viewType = VK_IMAGE_VIEW_TYPE_2D;
+	info.image = image;
+	info.format = format;
+	info.subresourceRange.baseMipLevel = 0;
+	info.subresourceRange.levelCount = 1;
+	info.subresourceRange.baseArrayLayer = 0;
+	info.subresourceRange.layerCount = 1;
+	info.subresourceRange.aspectMask = aspectFlags;
+
+	return info;
+}
+
+
+VkResult vkInit::VK_CHECK(VkResult x) {
+	if (x != VK_SUCCESS) {
+		std::cerr << "Error occurred: " << x << "\n";
+		abort();
+	}
+	return x;
 }
\ No newline at end of file
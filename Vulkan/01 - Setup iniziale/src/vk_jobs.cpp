@@ -0,0 +1,72 @@
+#include "../include/vk_jobs.hpp"
+
+// Indice del worker che esegue il thread corrente, ~0 per i thread esterni al sistema.
+static thread_local uint32_t tlsWorkerIndex = ~0u;
+
+/*
+* Avvia i worker. Con threadCount = 0 ne usiamo uno per core meno uno,
+* lasciando un core al thread principale che registra e invia i fotogrammi.
+*/
+void JobSystem::init(uint32_t threadCount)
+{
+	if (threadCount == 0) {
+		uint32_t cores = std::thread::hardware_concurrency();
+		threadCount = cores > 1 ? cores - 1 : 1;
+	}
+
+	_stopping = false;
+
+	for (uint32_t i = 0; i < threadCount; i++) {
+		_workers.emplace_back(&JobSystem::worker_loop, this, i);
+	}
+}
+
+/*
+* Ferma i worker dopo che hanno svuotato la coda dei lavori.
+*/
+void JobSystem::shutdown()
+{
+	if (_workers.empty()) {
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		_stopping = true;
+	}
+	_condition.notify_all();
+
+	for (std::thread& worker : _workers) {
+		worker.join();
+	}
+
+	_workers.clear();
+}
+
+uint32_t JobSystem::current_worker() const
+{
+	return tlsWorkerIndex < _workers.size() ? tlsWorkerIndex : worker_count();
+}
+
+void JobSystem::worker_loop(uint32_t index)
+{
+	tlsWorkerIndex = index;
+
+	while (true) {
+		std::function<void()> job;
+
+		{
+			std::unique_lock<std::mutex> lock(_mutex);
+			_condition.wait(lock, [this]() { return _stopping || !_jobs.empty(); });
+
+			if (_jobs.empty()) {
+				return;
+			}
+
+			job = std::move(_jobs.front());
+			_jobs.pop_front();
+		}
+
+		job();
+	}
+}
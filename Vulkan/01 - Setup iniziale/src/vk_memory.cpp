@@ -0,0 +1,137 @@
+#include "../include/vk_memory.hpp"
+#include <algorithm>
+#include <fstream>
+#include <fmt/core.h>
+#include <fmt/format.h>
+
+static double megabytes(VkDeviceSize bytes)
+{
+	return double(bytes) / (1024.0 * 1024.0);
+}
+
+const char* memory_category_name(MemoryCategory category)
+{
+	switch (category) {
+	case MemoryCategory::DrawTargets:
+		return "draw";
+	case MemoryCategory::Staging:
+		return "staging";
+	case MemoryCategory::FrameArenas:
+		return "arene";
+	case MemoryCategory::Readback:
+		return "readback";
+	case MemoryCategory::Count:
+		break;
+	}
+
+	return "altro";
+}
+
+void MemoryMonitor::init(VmaAllocator allocator)
+{
+	_allocator = allocator;
+	vmaGetMemoryProperties(_allocator, &_memoryProperties);
+}
+
+void MemoryMonitor::track(VmaAllocation allocation, MemoryCategory category)
+{
+	vmaSetAllocationName(_allocator, allocation, memory_category_name(category));
+	_tracked.push_back({ allocation, category });
+}
+
+void MemoryMonitor::untrack(VmaAllocation allocation)
+{
+	auto it = std::find_if(_tracked.begin(), _tracked.end(),
+		[allocation](const TrackedAllocation& tracked) { return tracked.allocation == allocation; });
+
+	if (it != _tracked.end()) {
+		*it = _tracked.back();
+		_tracked.pop_back();
+	}
+}
+
+/*
+* vmaSetCurrentFrameIndex fa rileggere a VMA il budget dal driver, poi prendiamo
+* uso e budget di ogni heap. Gli heap non locali (memoria di sistema) non contano nella pressione.
+*/
+float MemoryMonitor::poll(uint32_t frameIndex)
+{
+	vmaSetCurrentFrameIndex(_allocator, frameIndex);
+	vmaGetHeapBudgets(_allocator, _budgets);
+
+	float pressure = 0.0f;
+
+	for (uint32_t heap = 0; heap < _memoryProperties->memoryHeapCount; heap++) {
+		if (!(_memoryProperties->memoryHeaps[heap].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT) || _budgets[heap].budget == 0) {
+			continue;
+		}
+
+		pressure = std::max(pressure, float(double(_budgets[heap].usage) / double(_budgets[heap].budget)));
+	}
+
+	return pressure;
+}
+
+/*
+* Stampa i budget letti dall'ultimo poll(), la memoria per categoria e i totali di VMA.
+* La differenza tra i byte dei blocchi e quelli delle allocazioni è la memoria
+* riservata da VMA ma non ancora usata.
+*/
+void MemoryMonitor::log(uint64_t frameNumber) const
+{
+	std::string line = fmt::format("Memoria GPU frame {}:", frameNumber);
+
+	for (uint32_t heap = 0; heap < _memoryProperties->memoryHeapCount; heap++) {
+		bool local = _memoryProperties->memoryHeaps[heap].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT;
+
+		line += fmt::format(" heap {}{} {:.1f}/{:.1f} MB", heap, local ? " (locale)" : "",
+							megabytes(_budgets[heap].usage), megabytes(_budgets[heap].budget));
+	}
+
+	uint32_t counts[uint32_t(MemoryCategory::Count)] = {};
+	VkDeviceSize bytes[uint32_t(MemoryCategory::Count)] = {};
+
+	for (const TrackedAllocation& tracked : _tracked) {
+		VmaAllocationInfo info;
+		vmaGetAllocationInfo(_allocator, tracked.allocation, &info);
+
+		counts[uint32_t(tracked.category)]++;
+		bytes[uint32_t(tracked.category)] += info.size;
+	}
+
+	line += " |";
+	for (uint32_t category = 0; category < uint32_t(MemoryCategory::Count); category++) {
+		line += fmt::format(" {} {} ({:.1f} MB)", memory_category_name(MemoryCategory(category)),
+							counts[category], megabytes(bytes[category]));
+	}
+
+	VmaTotalStatistics stats;
+	vmaCalculateStatistics(_allocator, &stats);
+
+	line += fmt::format(" | {} blocchi {:.1f} MB, {} allocazioni {:.1f} MB",
+						stats.total.statistics.blockCount, megabytes(stats.total.statistics.blockBytes),
+						stats.total.statistics.allocationCount, megabytes(stats.total.statistics.allocationBytes));
+
+	fmt::print("{}\n", line);
+}
+
+/*
+* Scrive la mappa dettagliata dell'allocatore in JSON, con ogni blocco e ogni allocazione.
+*/
+bool MemoryMonitor::dump_json(const std::string& path) const
+{
+	char* json = nullptr;
+	vmaBuildStatsString(_allocator, &json, VK_TRUE);
+
+	std::ofstream file(path);
+	file << json;
+	vmaFreeStatsString(_allocator, json);
+
+	if (!file) {
+		fmt::print("Impossibile scrivere le statistiche della memoria: {}\n", path);
+		return false;
+	}
+
+	fmt::print("Statistiche della memoria salvate in {}\n", path);
+	return true;
+}
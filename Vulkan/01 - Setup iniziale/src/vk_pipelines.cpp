@@ -1,52 +1,477 @@
-#include "../include/vk_pipelines.hpp"
-#include "../include/vk_init.hpp"
-#include <fstream>
-
-
-/*
-* Funzione che carica il file delle shader.
-* 
-* Calcola la dimensione del file mettendo il cursore alla fine di esso
-* 
-* poi, SPIR-V si aspetta un buffer uint32_t allocato.
-* 
-* Infine si mette il cursore all'inizio per leggere tutti i byte della shader
-* 
-* per creare lo shader module.
-* 
-* La dimensione dello shader module deve essere in bytes, quindi moltiplichiamo
-* la dimensione del buffer per il tipo di dato che vuole SPIR-V per l'allocazione.
-* 
-* Infine controlliamo che la shader venga compilata.
-* 
-*/
-bool vkInit::load_shader_module(const char* filePath, VkDevice device, VkShaderModule* outShaderModule)
-{
-	std::ifstream file(filePath, std::ios::ate | std::ios::binary);
-
-	if (!file.is_open()) {
-		return false;
-	}
-
-	size_t fileSize = (size_t)file.tellg();
-
-	std::vector<uint32_t> buffer(fileSize / sizeof(uint32_t));
-
-	file.seekg(0);
-	file.read((char*)buffer.data(), fileSize);
-	file.close();
-
-
-	VkShaderModuleCreateInfo createInfo = {};
-	createInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
-	createInfo.pNext = nullptr;
-	createInfo.codeSize = buffer.size() * sizeof(uint32_t);
-	createInfo.pCode = buffer.data();
-
-
-	VkShaderModule shaderModule;
-	vkInit::VK_CHECK(vkCreateShaderModule(device, &createInfo, nullptr, &shaderModule));
-	*outShaderModule = shaderModule;
-
-	return true;
-}
\ No newline at end of file
+#include "../include/vk_pipelines.hpp"
+#include "../include/vk_init.hpp"
+#include "../include/vk_files.hpp"
+#include "../include/vk_bundle.hpp"
+#include <fstream>
+#include <vector>
+#include <cstring>
+#include <filesystem>
+#include <algorithm>
+#include <chrono>
+#include <fmt/core.h>
+
+
+/*
+* Ritorna le parole SPIR-V di un file mappato.
+*
+* Con mmap l'indirizzo è allineato alla pagina e le parole si leggono direttamente
+* dalla mappatura. Se non lo fosse le copiamo in fallback.
+* Un file con dimensione non multipla di 4 byte ritorna uno span vuoto.
+*/
+static std::span<const uint32_t> spirv_words(const MappedFile& file, std::vector<uint32_t>& fallback)
+{
+	std::span<const std::byte> bytes = file.bytes();
+
+	if (bytes.size() % sizeof(uint32_t) != 0) {
+		return {};
+	}
+
+	if (reinterpret_cast<uintptr_t>(bytes.data()) % alignof(uint32_t) != 0) {
+		fallback.resize(bytes.size() / sizeof(uint32_t));
+		std::memcpy(fallback.data(), bytes.data(), bytes.size());
+		return fallback;
+	}
+
+	return { reinterpret_cast<const uint32_t*>(bytes.data()), bytes.size() / sizeof(uint32_t) };
+}
+
+/*
+* Funzione che carica il file delle shader.
+* 
+* Il file viene mappato in memoria (vedi MappedFile) e le parole SPIR-V
+* vengono passate direttamente a vkCreateShaderModule, senza allocare un buffer
+* e copiarci dentro il file. La mappatura si chiude subito dopo la creazione del module,
+* il driver non tiene riferimenti al codice.
+* 
+* Infine controlliamo che la shader venga compilata.
+* 
+*/
+bool vkInit::load_shader_module(const char* filePath, VkDevice device, VkShaderModule* outShaderModule)
+{
+	MappedFile file;
+
+	if (!file.open(filePath)) {
+		return false;
+	}
+
+	std::vector<uint32_t> fallback;
+	bool loaded = load_shader_module(spirv_words(file, fallback), device, outShaderModule);
+
+	file.close();
+
+	if (!loaded) {
+		fmt::print("File SPIR-V non valido: {}\n", filePath);
+	}
+
+	return loaded;
+}
+
+/*
+* Crea lo shader module da parole SPIR-V già in memoria (file mappato o archivio di shader).
+*
+* Prima di passarle al driver controlliamo il numero magico all'inizio del modulo:
+* un file troncato o di un altro tipo farebbe fallire vkCreateShaderModule
+* o, senza validation layer, rompere il driver.
+*
+* Un errore del driver non ferma l'engine: durante l'hot-reload questa funzione gira
+* su un worker, e la pipeline precedente deve restare in uso.
+*/
+bool vkInit::load_shader_module(std::span<const uint32_t> code, VkDevice device, VkShaderModule* outShaderModule)
+{
+	constexpr uint32_t spirvMagic = 0x07230203;
+
+	// l'intestazione SPIR-V è di 5 parole: magic, versione, generatore, bound e schema.
+	if (code.size() < 5 || code[0] != spirvMagic) {
+		return false;
+	}
+
+	VkShaderModuleCreateInfo createInfo = {};
+	createInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+	createInfo.pNext = nullptr;
+	createInfo.codeSize = code.size_bytes();
+	createInfo.pCode = code.data();
+
+
+	VkShaderModule shaderModule;
+	VkResult result = vkCreateShaderModule(device, &createInfo, nullptr, &shaderModule);
+
+	if (result != VK_SUCCESS) {
+		fmt::print("vkCreateShaderModule fallita: {}\n", int(result));
+		return false;
+	}
+
+	*outShaderModule = shaderModule;
+
+	return true;
+}
+
+/*
+* Controlla che il blob letto dal disco sia stato creato da questo dispositivo.
+*
+* L'intestazione (VkPipelineCacheHeaderVersionOne) è definita dalla specifica
+* Vulkan ed è uguale per tutti i driver, il resto del blob invece è privato del driver.
+*/
+static bool validate_cache_header(const std::vector<char>& data, const VkPhysicalDeviceProperties& properties)
+{
+	VkPipelineCacheHeaderVersionOne header;
+
+	if (data.size() < sizeof(header)) {
+		return false;
+	}
+
+	std::memcpy(&header, data.data(), sizeof(header));
+
+	return header.headerSize >= sizeof(header) &&
+		   header.headerVersion == VK_PIPELINE_CACHE_HEADER_VERSION_ONE &&
+		   header.vendorID == properties.vendorID &&
+		   header.deviceID == properties.deviceID &&
+		   std::memcmp(header.pipelineCacheUUID, properties.pipelineCacheUUID, VK_UUID_SIZE) == 0;
+}
+
+/*
+* Carica la cache dal file, se esiste ed è valida, altrimenti crea una cache vuota.
+* Se filePath è vuoto la cache viene creata ma non verrà mai salvata.
+*/
+void PipelineCache::init(VkDevice device, const VkPhysicalDeviceProperties& properties, const std::string& filePath)
+{
+	path = filePath;
+	warm = false;
+
+	std::vector<char> data;
+
+	if (!path.empty()) {
+		std::ifstream file(path, std::ios::ate | std::ios::binary);
+
+		if (file.is_open()) {
+			data.resize((size_t)file.tellg());
+			file.seekg(0);
+			file.read(data.data(), data.size());
+
+			if (!validate_cache_header(data, properties)) {
+				fmt::print("Pipeline cache {} non valida per questo dispositivo, verrà ricreata\n", path);
+				data.clear();
+			}
+		}
+	}
+
+	VkPipelineCacheCreateInfo cacheInfo = {};
+	cacheInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+	cacheInfo.pNext = nullptr;
+	cacheInfo.initialDataSize = data.size();
+	cacheInfo.pInitialData = data.empty() ? nullptr : data.data();
+
+	vkInit::VK_CHECK(vkCreatePipelineCache(device, &cacheInfo, nullptr, &cache));
+
+	warm = !data.empty();
+}
+
+/*
+* Scrive la cache su disco. Scriviamo prima un file temporaneo e poi lo rinominiamo,
+* cosi una chiusura a metà scrittura non lascia un file corrotto.
+*/
+bool PipelineCache::save(VkDevice device) const
+{
+	if (cache == VK_NULL_HANDLE || path.empty()) {
+		return false;
+	}
+
+	size_t dataSize = 0;
+	vkInit::VK_CHECK(vkGetPipelineCacheData(device, cache, &dataSize, nullptr));
+
+	std::vector<char> data(dataSize);
+	vkInit::VK_CHECK(vkGetPipelineCacheData(device, cache, &dataSize, data.data()));
+
+	const std::string tmpPath = path + ".tmp";
+	{
+		std::ofstream file(tmpPath, std::ios::binary | std::ios::trunc);
+
+		if (!file.is_open()) {
+			return false;
+		}
+
+		file.write(data.data(), dataSize);
+
+		if (!file.good()) {
+			return false;
+		}
+	}
+
+	std::error_code error;
+	std::filesystem::rename(tmpPath, path, error);
+
+	return !error;
+}
+
+void PipelineCache::destroy(VkDevice device)
+{
+	if (cache != VK_NULL_HANDLE) {
+		vkDestroyPipelineCache(device, cache, nullptr);
+		cache = VK_NULL_HANDLE;
+	}
+}
+
+/*
+* Il nome di una shader è il nome del file fino al primo punto, quindi
+* "shaders/gradient_pixels.comp.spv" diventa "gradient_pixels".
+*/
+std::string vkutil::shader_name(const std::string& path)
+{
+	std::string fileName = std::filesystem::path(path).filename().string();
+	return fileName.substr(0, fileName.find('.'));
+}
+
+/*
+* Cerca i file SPIR-V nella cartella delle shader e crea una descrizione per ognuno,
+* con il nome ricavato da shader_name().
+* Le descrizioni sono ordinate per nome, cosi l'ordine non dipende dal file system.
+*/
+std::vector<ComputePipelineDesc> vkutil::find_compute_shaders(const std::string& shaderDir, VkPipelineLayout layout)
+{
+	namespace fs = std::filesystem;
+
+	std::vector<ComputePipelineDesc> descs;
+
+	std::error_code error;
+	for (const auto& entry : fs::directory_iterator(shaderDir, error)) {
+		if (entry.is_regular_file() && entry.path().extension() == ".spv") {
+			ComputePipelineDesc desc;
+			desc.name = shader_name(entry.path().string());
+			desc.shaderPath = entry.path().string();
+			desc.layout = layout;
+			descs.push_back(desc);
+		}
+	}
+
+	if (error) {
+		fmt::print("Impossibile leggere la cartella delle shader {}: {}\n", shaderDir, error.message());
+	}
+
+	std::sort(descs.begin(), descs.end(), [](const ComputePipelineDesc& a, const ComputePipelineDesc& b) {
+		return a.name < b.name;
+	});
+
+	return descs;
+}
+
+/*
+* Crea una compute pipeline: crea lo shader module e compila la pipeline.
+*
+* Il codice SPIR-V arriva dall'archivio delle shader (desc.code) oppure,
+* se manca, dal file desc.shaderPath mappato in memoria. In entrambi i casi
+* calcoliamo l'hash del contenuto e lo salviamo nella voce.
+*
+* Se l'hash è uguale a desc.skipHash la shader non è cambiata: ritorniamo la voce
+* senza module né pipeline, con contentHash impostato.
+* Se la shader non può essere caricata o il driver non riesce a creare la pipeline,
+* la voce ritornata ha module e pipeline = VK_NULL_HANDLE.
+*/
+PipelineEntry vkutil::build_compute_pipeline(VkDevice device, VkPipelineCache cache, const ComputePipelineDesc& desc)
+{
+	auto start = std::chrono::steady_clock::now();
+
+	PipelineEntry entry;
+	entry.name = desc.name;
+	entry.shaderPath = desc.shaderPath;
+	entry.layout = desc.layout;
+	entry.bindPoint = VK_PIPELINE_BIND_POINT_COMPUTE;
+
+	MappedFile file;
+	std::vector<uint32_t> fallback;
+	std::span<const uint32_t> code = desc.code;
+
+	if (code.empty() && desc.copyFile) {
+		if (!read_file_words(desc.shaderPath, fallback)) {
+			fmt::print("Failed to load shader: {}\n", desc.shaderPath);
+			return entry;
+		}
+		code = fallback;
+	}
+	else if (code.empty()) {
+		if (!file.open(desc.shaderPath)) {
+			fmt::print("Failed to load shader: {}\n", desc.shaderPath);
+			return entry;
+		}
+		code = spirv_words(file, fallback);
+	}
+
+	entry.contentHash = desc.code.empty() ? hash_bytes(std::as_bytes(code)) : desc.codeHash;
+
+	bool unchanged = desc.skipHash != 0 && entry.contentHash == desc.skipHash;
+	bool loaded = !unchanged && vkInit::load_shader_module(code, device, &entry.module);
+
+	// dopo la creazione del module il codice non serve più.
+	file.close();
+
+	if (unchanged) {
+		return entry;
+	}
+
+	if (!loaded) {
+		fmt::print("Failed to load shader: {}\n", desc.shaderPath);
+		entry.module = VK_NULL_HANDLE;
+		return entry;
+	}
+
+	std::chrono::duration<double, std::milli> moduleTime = std::chrono::steady_clock::now() - start;
+
+	VkPipelineShaderStageCreateInfo stageinfo{};
+	stageinfo.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+	stageinfo.pNext = nullptr;
+	stageinfo.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+	stageinfo.module = entry.module;
+	stageinfo.pName = desc.entryPoint;
+
+	VkComputePipelineCreateInfo computePipelineCreateInfo{};
+	computePipelineCreateInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+	computePipelineCreateInfo.pNext = nullptr;
+	computePipelineCreateInfo.layout = desc.layout;
+	computePipelineCreateInfo.stage = stageinfo;
+
+	VkResult result = vkCreateComputePipelines(device, cache, 1, &computePipelineCreateInfo, nullptr, &entry.pipeline);
+
+	if (result != VK_SUCCESS) {
+		fmt::print("Failed to create pipeline: {} ({})\n", desc.shaderPath, int(result));
+		vkDestroyShaderModule(device, entry.module, nullptr);
+		entry.module = VK_NULL_HANDLE;
+		entry.pipeline = VK_NULL_HANDLE;
+		return entry;
+	}
+
+	std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+	fmt::print("Loaded shader: {} (module {:.2f} ms, totale {:.2f} ms)\n", desc.shaderPath, moduleTime.count(),
+			   elapsed.count());
+
+	return entry;
+}
+
+/*
+* Crea una descrizione per ogni shader dell'archivio. Il codice punta nella
+* mappatura dell'archivio, che deve restare aperto finché le pipeline non sono create.
+*/
+std::vector<ComputePipelineDesc> vkutil::bundled_compute_shaders(const ShaderBundle& bundle, VkPipelineLayout layout)
+{
+	std::vector<ComputePipelineDesc> descs;
+	descs.reserve(bundle.count());
+
+	for (uint32_t i = 0; i < bundle.count(); i++) {
+		BundledShader shader = bundle.shader(i);
+
+		ComputePipelineDesc desc;
+		desc.name = std::string(shader.name);
+		desc.shaderPath = bundle.path + ":" + desc.name;
+		desc.layout = layout;
+		desc.code = shader.code;
+		desc.codeHash = shader.hash;
+		descs.push_back(desc);
+	}
+
+	return descs;
+}
+
+/*
+* Crea le compute pipeline in parallelo sui worker del JobSystem, una per lavoro.
+*
+* vkCreateComputePipelines può essere chiamata da più thread con la stessa
+* VkPipelineCache, la sincronizzazione della cache la gestisce il driver.
+*
+* Alla fine raccogliamo i risultati nell'ordine delle descrizioni,
+* le pipeline che non è stato possibile creare vengono scartate.
+*/
+std::vector<PipelineEntry> vkutil::build_compute_pipelines(VkDevice device, VkPipelineCache cache, JobSystem& jobs,
+														   std::span<const ComputePipelineDesc> descs)
+{
+	std::vector<std::future<PipelineEntry>> pending;
+	pending.reserve(descs.size());
+
+	for (const ComputePipelineDesc& desc : descs) {
+		pending.push_back(jobs.submit([device, cache, &desc]() {
+			return build_compute_pipeline(device, cache, desc);
+		}));
+	}
+
+	std::vector<PipelineEntry> entries;
+	entries.reserve(descs.size());
+
+	for (std::future<PipelineEntry>& result : pending) {
+		PipelineEntry entry = result.get();
+
+		if (entry.pipeline != VK_NULL_HANDLE) {
+			entries.push_back(std::move(entry));
+		}
+	}
+
+	return entries;
+}
+
+void PipelineRegistry::add_layout(const std::string& name, VkPipelineLayout layout)
+{
+	layouts[name] = layout;
+}
+
+VkPipelineLayout PipelineRegistry::find_layout(const std::string& name) const
+{
+	auto it = layouts.find(name);
+	return it != layouts.end() ? it->second : VK_NULL_HANDLE;
+}
+
+/*
+* Aggiunge una voce al registro e ne ritorna l'indice.
+* Se esiste già una voce con lo stesso nome, la nuova viene distrutta e scartata.
+*/
+uint32_t PipelineRegistry::add(VkDevice device, PipelineEntry entry)
+{
+	auto existing = byName.find(entry.name);
+
+	if (existing != byName.end()) {
+		fmt::print("Pipeline duplicata, ignorata: {} ({})\n", entry.name, entry.shaderPath);
+		vkDestroyPipeline(device, entry.pipeline, nullptr);
+		vkDestroyShaderModule(device, entry.module, nullptr);
+		return existing->second;
+	}
+
+	uint32_t index = uint32_t(entries.size());
+	byName.emplace(entry.name, index);
+	entries.push_back(std::move(entry));
+
+	return index;
+}
+
+uint32_t PipelineRegistry::find_index(const std::string& name) const
+{
+	auto it = byName.find(name);
+	return it != byName.end() ? it->second : invalidIndex;
+}
+
+/*
+* Sostituisce la voce all'indice dato e ritorna quella vecchia.
+* Chi chiama deve distruggerne pipeline e module quando la GPU non li usa più.
+*/
+PipelineEntry PipelineRegistry::replace(uint32_t index, PipelineEntry entry)
+{
+	PipelineEntry old = std::move(entries[index]);
+	entries[index] = std::move(entry);
+
+	return old;
+}
+
+const PipelineEntry* PipelineRegistry::find(const std::string& name) const
+{
+	uint32_t index = find_index(name);
+	return index != invalidIndex ? &entries[index] : nullptr;
+}
+
+void PipelineRegistry::destroy(VkDevice device)
+{
+	for (PipelineEntry& entry : entries) {
+		vkDestroyPipeline(device, entry.pipeline, nullptr);
+		vkDestroyShaderModule(device, entry.module, nullptr);
+	}
+
+	for (auto& [name, layout] : layouts) {
+		vkDestroyPipelineLayout(device, layout, nullptr);
+	}
+
+	entries.clear();
+	byName.clear();
+	layouts.clear();
+}
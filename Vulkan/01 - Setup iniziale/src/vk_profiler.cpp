@@ -0,0 +1,117 @@
+#include "../include/vk_profiler.hpp"
+#include "../include/vk_init.hpp"
+
+/*
+* Crea la query pool di tipo TIMESTAMP, con due query per ogni blocco.
+* timestampValidBits è quello della famiglia della queue su cui verranno scritti.
+*/
+void GpuTimestamps::init(VkDevice device, uint32_t timestampValidBits)
+{
+	scopeCount = 0;
+
+	if (timestampValidBits == 0) {
+		pool = VK_NULL_HANDLE;
+		validMask = 0;
+		return;
+	}
+
+	validMask = timestampValidBits >= 64 ? ~0ull : (1ull << timestampValidBits) - 1;
+
+	VkQueryPoolCreateInfo poolInfo = {};
+	poolInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+	poolInfo.pNext = nullptr;
+	poolInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+	poolInfo.queryCount = maxScopes * 2;
+
+	vkInit::VK_CHECK(vkCreateQueryPool(device, &poolInfo, nullptr, &pool));
+}
+
+void GpuTimestamps::destroy(VkDevice device)
+{
+	if (pool != VK_NULL_HANDLE) {
+		vkDestroyQueryPool(device, pool, nullptr);
+		pool = VK_NULL_HANDLE;
+	}
+}
+
+/*
+* Le query vanno resettate prima di essere riscritte, lo facciamo all'inizio
+* del command buffer, prima di qualsiasi blocco.
+*/
+void GpuTimestamps::reset(VkCommandBuffer cmd)
+{
+	scopeCount = 0;
+
+	if (pool != VK_NULL_HANDLE) {
+		vkCmdResetQueryPool(cmd, pool, 0, maxScopes * 2);
+	}
+}
+
+/*
+* Il timestamp di inizio usa lo stage TOP_OF_PIPE, quello di fine ALL_COMMANDS:
+* la GPU lo scrive solo quando tutti i comandi precedenti hanno terminato.
+*/
+uint32_t GpuTimestamps::begin_scope(VkCommandBuffer cmd, const char* name)
+{
+	if (pool == VK_NULL_HANDLE || scopeCount >= maxScopes) {
+		return maxScopes;
+	}
+
+	uint32_t scope = scopeCount++;
+	names[scope] = name;
+
+	vkCmdWriteTimestamp2(cmd, VK_PIPELINE_STAGE_2_TOP_OF_PIPE_BIT, pool, scope * 2);
+
+	return scope;
+}
+
+void GpuTimestamps::end_scope(VkCommandBuffer cmd, uint32_t scope)
+{
+	if (scope >= maxScopes) {
+		return;
+	}
+
+	vkCmdWriteTimestamp2(cmd, VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT, pool, scope * 2 + 1);
+}
+
+/*
+* Legge i risultati del frame. Va chiamata dopo aver atteso il completamento del frame,
+* quindi i risultati sono già disponibili e non serve il flag WAIT.
+*
+* timestampPeriod indica quanti nanosecondi corrispondono ad un incremento
+* del timestamp, lo prendiamo dai limiti del dispositivo fisico.
+*/
+void GpuTimestamps::collect(VkDevice device, float timestampPeriod, std::vector<GpuScopeTiming>& out)
+{
+	out.clear();
+
+	if (pool == VK_NULL_HANDLE || scopeCount == 0) {
+		return;
+	}
+
+	uint64_t results[maxScopes * 2];
+
+	VkResult result = vkGetQueryPoolResults(device, pool, 0, scopeCount * 2, sizeof(results), results,
+											sizeof(uint64_t), VK_QUERY_RESULT_64_BIT);
+
+	if (result != VK_SUCCESS) {
+		return;
+	}
+
+	for (uint32_t i = 0; i < scopeCount; i++) {
+		// in aritmetica modulo 2^validBits la differenza è corretta anche se il contatore è ripartito.
+		uint64_t ticks = (results[i * 2 + 1] - results[i * 2]) & validMask;
+		out.push_back({ names[i], double(ticks) * timestampPeriod / 1000000.0 });
+	}
+}
+
+GpuScope::GpuScope(GpuTimestamps& timestamps, VkCommandBuffer cmd, const char* name)
+	: _timestamps(timestamps), _cmd(cmd)
+{
+	_scope = _timestamps.begin_scope(_cmd, name);
+}
+
+GpuScope::~GpuScope()
+{
+	_timestamps.end_scope(_cmd, _scope);
+}
@@ -0,0 +1,172 @@
+#include "../include/vk_rendergraph.hpp"
+#include "../include/vk_init.hpp"
+#include <algorithm>
+#include <future>
+
+uint32_t RenderGraph::import_image(const char* name, VkImage image, ImageState& state)
+{
+	images.push_back({ name, image, &state, std::nullopt, false });
+	return uint32_t(images.size() - 1);
+}
+
+/*
+* Più accessi alla stessa immagine nello stesso passaggio vengono uniti in uno solo,
+* altrimenti il secondo genererebbe una barriera tra il passaggio e se stesso.
+* Gli accessi uniti devono richiedere lo stesso layout.
+*/
+void RenderGraph::add_pass(const char* name, std::vector<ImageAccess> accesses, RecordFunction record, bool sideEffect)
+{
+	std::vector<ImageAccess> merged;
+
+	for (const ImageAccess& access : accesses) {
+		auto existing = std::find_if(merged.begin(), merged.end(),
+			[&access](const ImageAccess& other) { return other.image == access.image; });
+
+		if (existing == merged.end()) {
+			merged.push_back(access);
+			continue;
+		}
+
+		existing->state.stage |= access.state.stage;
+		existing->state.access |= access.state.access;
+		existing->read = existing->read || access.read;
+		existing->write = existing->write || access.write;
+	}
+
+	passes.push_back({ name, std::move(merged), std::move(record), sideEffect, false });
+}
+
+void RenderGraph::mark_output(uint32_t image, std::optional<ImageState> finalState)
+{
+	images[image].output = true;
+	images[image].finalState = finalState;
+}
+
+/*
+* Visita i passaggi dall'ultimo al primo tenendo l'insieme delle immagini ancora necessarie,
+* che all'inizio sono le uscite del frame.
+*
+* Un passaggio serve se scrive un'immagine necessaria (o ha effetti collaterali).
+* In quel caso le immagini che scrive senza leggerle non servono più ai passaggi
+* precedenti, mentre quelle che legge diventano necessarie.
+*/
+void RenderGraph::cull()
+{
+	std::vector<bool> needed(images.size(), false);
+
+	for (size_t i = 0; i < images.size(); i++) {
+		needed[i] = images[i].output;
+	}
+
+	for (auto pass = passes.rbegin(); pass != passes.rend(); ++pass) {
+		bool used = pass->sideEffect || std::any_of(pass->accesses.begin(), pass->accesses.end(),
+			[&needed](const ImageAccess& access) { return access.write && needed[access.image]; });
+
+		pass->culled = !used;
+
+		if (!used) {
+			continue;
+		}
+
+		for (const ImageAccess& access : pass->accesses) {
+			if (access.write && !access.read) {
+				needed[access.image] = false;
+			}
+		}
+		for (const ImageAccess& access : pass->accesses) {
+			if (access.read) {
+				needed[access.image] = true;
+			}
+		}
+	}
+}
+
+void RenderGraph::execute(VkCommandBuffer cmd, GpuTimestamps& timestamps, bool fullBarriers,
+						  JobSystem* jobs, SecondaryFunction beginSecondary)
+{
+	cull();
+
+	/*
+	* I secondari non dipendono dalle barriere, che restano nel primario:
+	* avviamo subito la registrazione di tutti i passaggi, in parallelo con il ciclo qui sotto.
+	*/
+	std::vector<std::future<VkCommandBuffer>> secondaries(passes.size());
+
+	if (jobs) {
+		for (size_t i = 0; i < passes.size(); i++) {
+			if (passes[i].culled) {
+				continue;
+			}
+
+			const RecordFunction* record = &passes[i].record;
+			secondaries[i] = jobs->submit([record, &beginSecondary]() {
+				VkCommandBuffer secondary = beginSecondary();
+				(*record)(secondary);
+				vkInit::VK_CHECK(vkEndCommandBuffer(secondary));
+				return secondary;
+			});
+		}
+	}
+
+	stats = {};
+
+	ImageBarrierBatch barriers;
+	barriers.fullBarriers = fullBarriers;
+
+	std::vector<bool> touched(images.size(), false);
+
+	auto flush = [&]() {
+		if (!barriers.barriers.empty()) {
+			stats.barriers += uint32_t(barriers.barriers.size());
+			stats.barrierCalls++;
+		}
+		barriers.flush(cmd);
+	};
+
+	for (size_t i = 0; i < passes.size(); i++) {
+		Pass& pass = passes[i];
+
+		if (pass.culled) {
+			stats.culledPasses++;
+			continue;
+		}
+
+		stats.passes++;
+
+		GpuScope scope(timestamps, cmd, pass.name);
+
+		for (const ImageAccess& access : pass.accesses) {
+			ImageResource& resource = images[access.image];
+
+			// Primo uso nel frame in sola scrittura: il contenuto precedente non serve.
+			if (!touched[access.image] && !access.read) {
+				resource.state->layout = VK_IMAGE_LAYOUT_UNDEFINED;
+			}
+			touched[access.image] = true;
+
+			barriers.transition(resource.image, *resource.state, access.state);
+		}
+
+		flush();
+
+		if (secondaries[i].valid()) {
+			VkCommandBuffer secondary = secondaries[i].get();
+			vkCmdExecuteCommands(cmd, 1, &secondary);
+		}
+		else {
+			pass.record(cmd);
+		}
+	}
+
+	// Lascia le uscite nello stato richiesto, ad esempio PRESENT_SRC per la swapchain.
+	for (ImageResource& resource : images) {
+		if (resource.output && resource.finalState) {
+			barriers.transition(resource.image, *resource.state, *resource.finalState);
+		}
+	}
+
+	if (!barriers.barriers.empty()) {
+		GpuScope scope(timestamps, cmd, "outputs");
+		flush();
+	}
+}
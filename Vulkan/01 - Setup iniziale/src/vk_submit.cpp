@@ -0,0 +1,148 @@
+#include "../include/vk_submit.hpp"
+#include "../include/vk_init.hpp"
+
+bool GpuFuture::is_ready() const
+{
+	if (value == 0) {
+		return true;
+	}
+
+	uint64_t completed = 0;
+	vkInit::VK_CHECK(vkGetSemaphoreCounterValue(device, timeline, &completed));
+
+	return completed >= value;
+}
+
+void GpuFuture::wait() const
+{
+	if (value == 0) {
+		return;
+	}
+
+	VkSemaphoreWaitInfo waitInfo = {};
+	waitInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO;
+	waitInfo.pNext = nullptr;
+	waitInfo.flags = 0;
+	waitInfo.semaphoreCount = 1;
+	waitInfo.pSemaphores = &timeline;
+	waitInfo.pValues = &value;
+
+	vkInit::VK_CHECK(vkWaitSemaphores(device, &waitInfo, UINT64_MAX));
+}
+
+/*
+* La command pool permette il reset dei singoli command buffer,
+* che vengono riusati quando il gruppo che contenevano è completato.
+*/
+void SubmitBatcher::init(VkDevice device, VkQueue queue, uint32_t queueFamily)
+{
+	_device = device;
+	_queue = queue;
+
+	VkCommandPoolCreateInfo poolInfo = vkInit::command_pool_create_info(queueFamily,
+		VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT);
+	vkInit::VK_CHECK(vkCreateCommandPool(_device, &poolInfo, nullptr, &_commandPool));
+
+	VkSemaphoreTypeCreateInfo timelineInfo = vkInit::timeline_semaphore_info(0);
+	VkSemaphoreCreateInfo semaphoreInfo = vkInit::semaphoreInfo(0);
+	semaphoreInfo.pNext = &timelineInfo;
+	vkInit::VK_CHECK(vkCreateSemaphore(_device, &semaphoreInfo, nullptr, &_timeline));
+
+	_nextValue = 1;
+}
+
+/*
+* Va chiamata con la GPU ferma, dopo vkDeviceWaitIdle. Le richieste mai inviate vengono scartate.
+*/
+void SubmitBatcher::destroy()
+{
+	_requests.clear();
+	_inFlight.clear();
+	_freeCommandBuffers.clear();
+
+	vkDestroySemaphore(_device, _timeline, nullptr);
+	vkDestroyCommandPool(_device, _commandPool, nullptr);
+}
+
+GpuFuture SubmitBatcher::submit(RecordFunction record)
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+
+	_requests.push_back(std::move(record));
+
+	return { _device, _timeline, _nextValue };
+}
+
+/*
+* Registra tutte le richieste in coda nello stesso command buffer, nell'ordine di arrivo,
+* e lo invia segnalando il valore promesso ai loro GpuFuture.
+*/
+uint64_t SubmitBatcher::flush()
+{
+	std::vector<RecordFunction> requests;
+	uint64_t value;
+
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+
+		if (_requests.empty()) {
+			return 0;
+		}
+
+		requests.swap(_requests);
+		value = _nextValue++;
+	}
+
+	retire_completed();
+
+	VkCommandBuffer cmd;
+	if (_freeCommandBuffers.empty()) {
+		VkCommandBufferAllocateInfo allocInfo = vkInit::command_buffer_allocate_info(_commandPool, 1, VK_COMMAND_BUFFER_LEVEL_PRIMARY);
+		vkInit::VK_CHECK(vkAllocateCommandBuffers(_device, &allocInfo, &cmd));
+	}
+	else {
+		cmd = _freeCommandBuffers.back();
+		_freeCommandBuffers.pop_back();
+		vkInit::VK_CHECK(vkResetCommandBuffer(cmd, 0));
+	}
+
+	VkCommandBufferBeginInfo beginInfo = vkInit::commandBufferBeginInfo(VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT);
+	vkInit::VK_CHECK(vkBeginCommandBuffer(cmd, &beginInfo));
+
+	for (RecordFunction& record : requests) {
+		record(cmd);
+	}
+
+	vkInit::VK_CHECK(vkEndCommandBuffer(cmd));
+
+	VkCommandBufferSubmitInfo cmdInfo = vkInit::command_buffer_submit_info(cmd);
+	VkSemaphoreSubmitInfo signalInfo = vkInit::semaphore_submit_info(VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT, _timeline, value);
+
+	VkSubmitInfo2 submit = vkInit::submit_info(&cmdInfo, &signalInfo, nullptr);
+	vkInit::VK_CHECK(vkQueueSubmit2(_queue, 1, &submit, VK_NULL_HANDLE));
+
+	_inFlight.push_back({ cmd, value });
+
+	return value;
+}
+
+void SubmitBatcher::wait(const GpuFuture& future)
+{
+	if (future.is_ready()) {
+		return;
+	}
+
+	flush();
+	future.wait();
+}
+
+void SubmitBatcher::retire_completed()
+{
+	uint64_t completed = 0;
+	vkInit::VK_CHECK(vkGetSemaphoreCounterValue(_device, _timeline, &completed));
+
+	while (!_inFlight.empty() && _inFlight.front().value <= completed) {
+		_freeCommandBuffers.push_back(_inFlight.front().cmd);
+		_inFlight.pop_front();
+	}
+}
@@ -0,0 +1,386 @@
+#include "../include/vk_upload.hpp"
+#include "../include/vk_buffers.hpp"
+#include "../include/vk_init.hpp"
+#include <cstring>
+
+/*
+* L'anello viene allocato in memoria visibile dalla CPU e resta mappato:
+* i dati vengono copiati con memcpy senza mappare e smappare ad ogni caricamento.
+*
+* La command pool permette il reset dei singoli command buffer, che vengono riusati
+* quando il gruppo di copie che contenevano è completato.
+*/
+void StagingUploader::init(VkDevice device, VmaAllocator allocator, VkQueue queue, uint32_t queueFamily,
+						   uint32_t graphicsQueueFamily, size_t ringSize)
+{
+	_device = device;
+	_allocator = allocator;
+	_queue = queue;
+	_queueFamily = queueFamily;
+	_graphicsQueueFamily = graphicsQueueFamily;
+
+	VkCommandPoolCreateInfo poolInfo = vkInit::command_pool_create_info(_queueFamily,
+		VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT);
+	vkInit::VK_CHECK(vkCreateCommandPool(_device, &poolInfo, nullptr, &_commandPool));
+
+	_ringSize = ringSize;
+	_ring = vkutil::create_buffer(_allocator, _ringSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+								  VMA_MEMORY_USAGE_CPU_ONLY, VMA_ALLOCATION_CREATE_MAPPED_BIT);
+	_head = 0;
+	_used = 0;
+
+	VkSemaphoreTypeCreateInfo timelineInfo = vkInit::timeline_semaphore_info(0);
+	VkSemaphoreCreateInfo semaphoreInfo = vkInit::semaphoreInfo(0);
+	semaphoreInfo.pNext = &timelineInfo;
+	vkInit::VK_CHECK(vkCreateSemaphore(_device, &semaphoreInfo, nullptr, &_timeline));
+
+	_nextValue = 1;
+	_acquiredValue = 0;
+	_readyValue = 0;
+
+	_pending = {};
+	_hasPending = false;
+	_stats = {};
+}
+
+/*
+* Va chiamata con la GPU ferma, dopo vkDeviceWaitIdle.
+*/
+void StagingUploader::destroy()
+{
+	if (_hasPending) {
+		_inFlight.push_back(std::move(_pending));
+		_hasPending = false;
+	}
+
+	for (Batch& batch : _inFlight) {
+		for (const AllocatedBuffer& buffer : batch.oversized) {
+			vkutil::destroy_buffer(_allocator, buffer);
+		}
+	}
+	_inFlight.clear();
+
+	vkDestroySemaphore(_device, _timeline, nullptr);
+	vkutil::destroy_buffer(_allocator, _ring);
+	vkDestroyCommandPool(_device, _commandPool, nullptr);
+}
+
+bool StagingUploader::is_complete(uint64_t value) const
+{
+	uint64_t completed = 0;
+	vkInit::VK_CHECK(vkGetSemaphoreCounterValue(_device, _timeline, &completed));
+
+	return completed >= value;
+}
+
+void StagingUploader::wait(uint64_t value) const
+{
+	VkSemaphoreWaitInfo waitInfo = {};
+	waitInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO;
+	waitInfo.pNext = nullptr;
+	waitInfo.flags = 0;
+	waitInfo.semaphoreCount = 1;
+	waitInfo.pSemaphores = &_timeline;
+	waitInfo.pValues = &value;
+
+	vkInit::VK_CHECK(vkWaitSemaphores(_device, &waitInfo, UINT64_MAX));
+}
+
+/*
+* Command buffer del gruppo in preparazione, avviato al primo caricamento dopo un flush().
+*/
+VkCommandBuffer StagingUploader::pending_command_buffer()
+{
+	if (_hasPending) {
+		return _pending.cmd;
+	}
+
+	retire_completed();
+
+	VkCommandBuffer cmd;
+	if (_freeCommandBuffers.empty()) {
+		VkCommandBufferAllocateInfo allocInfo = vkInit::command_buffer_allocate_info(_commandPool, 1, VK_COMMAND_BUFFER_LEVEL_PRIMARY);
+		vkInit::VK_CHECK(vkAllocateCommandBuffers(_device, &allocInfo, &cmd));
+	}
+	else {
+		cmd = _freeCommandBuffers.back();
+		_freeCommandBuffers.pop_back();
+		vkInit::VK_CHECK(vkResetCommandBuffer(cmd, 0));
+	}
+
+	VkCommandBufferBeginInfo beginInfo = vkInit::commandBufferBeginInfo(VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT);
+	vkInit::VK_CHECK(vkBeginCommandBuffer(cmd, &beginInfo));
+
+	_pending = {};
+	_pending.cmd = cmd;
+	_pending.value = _nextValue;
+	_hasPending = true;
+
+	return cmd;
+}
+
+/*
+* Copia i dati nell'anello e ritorna la loro posizione nel buffer di staging.
+*
+* Se i dati non entrano alla fine dell'anello ripartiamo dall'inizio: lo spazio saltato
+* conta come occupato e viene liberato insieme al gruppo. Se l'anello è pieno inviamo il gruppo
+* in preparazione e attendiamo i gruppi più vecchi finché non si libera abbastanza spazio.
+*/
+VkDeviceSize StagingUploader::stage(const void* data, size_t size, VkBuffer& stagingBuffer)
+{
+	pending_command_buffer();
+
+	if (size > _ringSize) {
+		AllocatedBuffer temporary = vkutil::create_buffer(_allocator, size, VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+														  VMA_MEMORY_USAGE_CPU_ONLY, VMA_ALLOCATION_CREATE_MAPPED_BIT);
+		std::memcpy(temporary.info.pMappedData, data, size);
+		vmaFlushAllocation(_allocator, temporary.allocation, 0, VK_WHOLE_SIZE);
+
+		_pending.oversized.push_back(temporary);
+		_stats.oversized++;
+
+		stagingBuffer = temporary.buffer;
+		return 0;
+	}
+
+	while (true) {
+		// Con l'anello vuoto ripartiamo dall'inizio, altrimenti un caricamento più grande
+		// dello spazio prima e dopo _head non entrerebbe mai.
+		if (_used == 0) {
+			_head = 0;
+		}
+
+		size_t offset = (_head + alignment - 1) & ~(alignment - 1);
+		if (offset + size > _ringSize) {
+			offset = 0;
+		}
+
+		// byte consumati dalla posizione attuale: padding, eventuale fine dell'anello saltata e dati.
+		size_t consumed = offset >= _head ? offset - _head + size : _ringSize - _head + size;
+
+		if (_used + consumed <= _ringSize) {
+			std::memcpy(static_cast<char*>(_ring.info.pMappedData) + offset, data, size);
+			vmaFlushAllocation(_allocator, _ring.allocation, offset, size);
+
+			_head = offset + size;
+			_used += consumed;
+			_pending.consumed += consumed;
+
+			stagingBuffer = _ring.buffer;
+			return offset;
+		}
+
+		// Il gruppo in preparazione occupa l'anello da solo: lo inviamo e ne iniziamo uno nuovo.
+		_stats.stalls++;
+
+		if (_inFlight.empty()) {
+			flush();
+			pending_command_buffer();
+		}
+
+		if (!_inFlight.empty()) {
+			wait(_inFlight.front().value);
+			retire_completed();
+		}
+	}
+}
+
+/*
+* Accoda la copia dei dati in un buffer. Con una queue di trasferimento separata
+* il buffer viene rilasciato alla famiglia grafica.
+*/
+uint64_t StagingUploader::upload_buffer(const void* data, size_t size, VkBuffer destination, VkDeviceSize destinationOffset)
+{
+	VkBuffer stagingBuffer;
+	VkDeviceSize stagingOffset = stage(data, size, stagingBuffer);
+	VkCommandBuffer cmd = _pending.cmd;
+
+	VkBufferCopy region = {};
+	region.srcOffset = stagingOffset;
+	region.dstOffset = destinationOffset;
+	region.size = size;
+
+	vkCmdCopyBuffer(cmd, stagingBuffer, destination, 1, &region);
+
+	if (transfers_ownership()) {
+		VkBufferMemoryBarrier2 barrier = { .sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER_2 };
+		barrier.pNext = nullptr;
+		barrier.srcQueueFamilyIndex = _queueFamily;
+		barrier.dstQueueFamilyIndex = _graphicsQueueFamily;
+		barrier.buffer = destination;
+		barrier.offset = destinationOffset;
+		barrier.size = size;
+
+		// Rilascio: rende disponibile la scrittura della copia.
+		barrier.srcStageMask = VK_PIPELINE_STAGE_2_COPY_BIT;
+		barrier.srcAccessMask = VK_ACCESS_2_TRANSFER_WRITE_BIT;
+		barrier.dstStageMask = VK_PIPELINE_STAGE_2_NONE;
+		barrier.dstAccessMask = VK_ACCESS_2_NONE;
+
+		VkDependencyInfo depInfo = {};
+		depInfo.sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO;
+		depInfo.pNext = nullptr;
+		depInfo.bufferMemoryBarrierCount = 1;
+		depInfo.pBufferMemoryBarriers = &barrier;
+		vkCmdPipelineBarrier2(cmd, &depInfo);
+
+		// Acquisizione, registrata dalla queue grafica: non sappiamo chi userà il buffer.
+		barrier.srcStageMask = VK_PIPELINE_STAGE_2_NONE;
+		barrier.srcAccessMask = VK_ACCESS_2_NONE;
+		barrier.dstStageMask = VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT;
+		barrier.dstAccessMask = VK_ACCESS_2_MEMORY_READ_BIT;
+		_pending.bufferAcquires.push_back(barrier);
+	}
+
+	_stats.uploads++;
+	_stats.bytes += size;
+
+	return _pending.value;
+}
+
+/*
+* Accoda la copia dei dati nel livello 0 di un'immagine. I dati devono essere compatti
+* (righe senza padding). L'immagine viene scartata, portata in TRANSFER_DST per la copia
+* e lasciata nel layout di finalState, direttamente o tramite il trasferimento alla famiglia grafica.
+*/
+uint64_t StagingUploader::upload_image(const void* data, size_t size, VkImage destination, VkExtent3D extent,
+									   const ImageState& finalState, VkImageAspectFlags aspectMask)
+{
+	VkBuffer stagingBuffer;
+	VkDeviceSize stagingOffset = stage(data, size, stagingBuffer);
+	VkCommandBuffer cmd = _pending.cmd;
+
+	ImageState state = ImageState::undefined();
+
+	ImageBarrierBatch barriers;
+	barriers.transition(destination, state, ImageState::transfer_dst(), aspectMask);
+	barriers.flush(cmd);
+
+	VkBufferImageCopy region = {};
+	region.bufferOffset = stagingOffset;
+	region.bufferRowLength = 0;
+	region.bufferImageHeight = 0;
+	region.imageSubresource.aspectMask = aspectMask;
+	region.imageSubresource.mipLevel = 0;
+	region.imageSubresource.baseArrayLayer = 0;
+	region.imageSubresource.layerCount = 1;
+	region.imageExtent = extent;
+
+	vkCmdCopyBufferToImage(cmd, stagingBuffer, destination, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
+
+	if (transfers_ownership()) {
+		barriers.release(destination, state, finalState.layout, _queueFamily, _graphicsQueueFamily, aspectMask);
+		barriers.flush(cmd);
+
+		// L'acquisizione viene registrata più tardi dalla queue grafica, con lo stesso cambio di layout.
+		ImageBarrierBatch acquire;
+		acquire.acquire(destination, state, finalState, _queueFamily, _graphicsQueueFamily, aspectMask);
+		_pending.imageAcquires.push_back(acquire.barriers.front());
+	}
+	else {
+		// Stessa famiglia: chi usa l'immagine attende il semaforo timeline, che copre anche questa barriera.
+		ImageState next = { finalState.layout, VK_PIPELINE_STAGE_2_NONE, VK_ACCESS_2_NONE };
+		barriers.transition(destination, state, next, aspectMask);
+		barriers.flush(cmd);
+	}
+
+	_stats.uploads++;
+	_stats.bytes += size;
+
+	return _pending.value;
+}
+
+/*
+* Invia il gruppo di copie in preparazione, se c'è, segnalando il suo valore del semaforo.
+*/
+void StagingUploader::flush()
+{
+	if (!_hasPending) {
+		return;
+	}
+
+	vkInit::VK_CHECK(vkEndCommandBuffer(_pending.cmd));
+
+	VkCommandBufferSubmitInfo cmdInfo = vkInit::command_buffer_submit_info(_pending.cmd);
+	VkSemaphoreSubmitInfo signalInfo = vkInit::semaphore_submit_info(VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT,
+																	 _timeline, _pending.value);
+
+	VkSubmitInfo2 submit = vkInit::submit_info(&cmdInfo, &signalInfo, nullptr);
+	vkInit::VK_CHECK(vkQueueSubmit2(_queue, 1, &submit, VK_NULL_HANDLE));
+
+	_nextValue++;
+	_stats.batches++;
+
+	_inFlight.push_back(std::move(_pending));
+	_hasPending = false;
+}
+
+/*
+* Libera lo spazio e i command buffer dei gruppi completati, in ordine di invio.
+* Le loro acquisizioni passano alla lista di quelle da registrare sulla queue grafica.
+*/
+void StagingUploader::retire_completed()
+{
+	if (_inFlight.empty()) {
+		return;
+	}
+
+	uint64_t completed = 0;
+	vkInit::VK_CHECK(vkGetSemaphoreCounterValue(_device, _timeline, &completed));
+
+	while (!_inFlight.empty() && _inFlight.front().value <= completed) {
+		Batch& batch = _inFlight.front();
+
+		_used -= batch.consumed;
+		for (const AllocatedBuffer& buffer : batch.oversized) {
+			vkutil::destroy_buffer(_allocator, buffer);
+		}
+
+		_readyBufferAcquires.insert(_readyBufferAcquires.end(), batch.bufferAcquires.begin(), batch.bufferAcquires.end());
+		_readyImageAcquires.insert(_readyImageAcquires.end(), batch.imageAcquires.begin(), batch.imageAcquires.end());
+		_readyValue = batch.value;
+
+		_freeCommandBuffers.push_back(batch.cmd);
+		_inFlight.pop_front();
+	}
+
+	// Senza byte occupati l'anello è vuoto: ripartiamo dall'inizio.
+	if (_used == 0) {
+		_head = 0;
+	}
+}
+
+/*
+* Registra nel command buffer grafico le acquisizioni dei caricamenti completati.
+*
+* Ritorna il valore del semaforo timeline che l'invio del frame deve attendere (già raggiunto,
+* quindi l'attesa non costa nulla, ma rende le copie visibili alla queue grafica),
+* oppure 0 se dall'ultima chiamata non si è completato nessun caricamento.
+*/
+uint64_t StagingUploader::acquire_completed(VkCommandBuffer cmd)
+{
+	retire_completed();
+
+	if (_readyValue <= _acquiredValue) {
+		return 0;
+	}
+
+	if (!_readyBufferAcquires.empty() || !_readyImageAcquires.empty()) {
+		VkDependencyInfo depInfo = {};
+		depInfo.sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO;
+		depInfo.pNext = nullptr;
+		depInfo.bufferMemoryBarrierCount = uint32_t(_readyBufferAcquires.size());
+		depInfo.pBufferMemoryBarriers = _readyBufferAcquires.data();
+		depInfo.imageMemoryBarrierCount = uint32_t(_readyImageAcquires.size());
+		depInfo.pImageMemoryBarriers = _readyImageAcquires.data();
+
+		vkCmdPipelineBarrier2(cmd, &depInfo);
+
+		_readyBufferAcquires.clear();
+		_readyImageAcquires.clear();
+	}
+
+	_acquiredValue = _readyValue;
+
+	return _acquiredValue;
+}
@@ -0,0 +1,177 @@
+/**
+ * @file shader_bundler.cpp
+ * @author Fabxx
+ * @brief Strumento da riga di comando che raccoglie i file .spv di una cartella
+ *        in un unico archivio (vedi vk_bundle.hpp per il formato).
+ * @version 0.1
+ * @date 2025-05-02
+ *
+ * @copyright Copyright (c) 2025
+ *
+ */
+
+#include "../include/vk_bundle.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <vector>
+
+struct InputShader {
+	std::string name;
+	std::string path;
+	std::vector<char> code;
+};
+
+static bool read_file(const std::string& path, std::vector<char>& out)
+{
+	std::ifstream file(path, std::ios::ate | std::ios::binary);
+
+	if (!file.is_open()) {
+		return false;
+	}
+
+	out.resize(size_t(file.tellg()));
+	file.seekg(0);
+	file.read(out.data(), std::streamsize(out.size()));
+
+	return bool(file);
+}
+
+// Scrive zeri fino al prossimo multiplo di alignment.
+static void pad_to(std::vector<char>& out, size_t alignment)
+{
+	out.resize((out.size() + alignment - 1) / alignment * alignment, 0);
+}
+
+/*
+* Uso: ShaderBundler <cartella shader> <archivio di uscita>
+*
+* Il nome di ogni shader è il nome del file fino al primo punto, come
+* per la scansione della cartella nell'engine. Due file con lo stesso nome
+* o un file che non è SPIR-V fanno fallire lo strumento, e quindi la build.
+* Anche una cartella senza file .spv è un errore: un archivio vuoto nasconderebbe
+* all'engine le shader compilate in seguito.
+*/
+int main(int argc, char* argv[])
+{
+	namespace fs = std::filesystem;
+
+	if (argc != 3) {
+		std::fprintf(stderr, "Uso: %s <cartella shader> <archivio di uscita>\n", argv[0]);
+		return 1;
+	}
+
+	std::vector<InputShader> shaders;
+
+	std::error_code error;
+	for (const auto& entry : fs::directory_iterator(argv[1], error)) {
+		if (!entry.is_regular_file() || entry.path().extension() != ".spv") {
+			continue;
+		}
+
+		InputShader shader;
+		std::string fileName = entry.path().filename().string();
+		shader.name = fileName.substr(0, fileName.find('.'));
+		shader.path = entry.path().string();
+
+		if (!read_file(shader.path, shader.code)) {
+			std::fprintf(stderr, "Impossibile leggere %s\n", shader.path.c_str());
+			return 1;
+		}
+
+		uint32_t magic = 0;
+		if (shader.code.size() >= sizeof(magic)) {
+			std::memcpy(&magic, shader.code.data(), sizeof(magic));
+		}
+
+		if (shader.code.size() % sizeof(uint32_t) != 0 || magic != 0x07230203) {
+			std::fprintf(stderr, "%s non è un file SPIR-V valido\n", shader.path.c_str());
+			return 1;
+		}
+
+		shaders.push_back(std::move(shader));
+	}
+
+	if (error) {
+		std::fprintf(stderr, "Impossibile leggere la cartella %s: %s\n", argv[1], error.message().c_str());
+		return 1;
+	}
+
+	if (shaders.empty()) {
+		std::fprintf(stderr, "Nessun file .spv in %s, archivio non creato\n", argv[1]);
+		return 1;
+	}
+
+	std::sort(shaders.begin(), shaders.end(), [](const InputShader& a, const InputShader& b) {
+		return a.name < b.name;
+	});
+
+	for (size_t i = 1; i < shaders.size(); i++) {
+		if (shaders[i].name == shaders[i - 1].name) {
+			std::fprintf(stderr, "Nome di shader duplicato: %s (%s, %s)\n", shaders[i].name.c_str(),
+						 shaders[i - 1].path.c_str(), shaders[i].path.c_str());
+			return 1;
+		}
+	}
+
+	// Indice e tabella dei nomi, poi i blob uno dopo l'altro.
+	ShaderBundleHeader header{};
+	header.magic = ShaderBundleHeader::magicValue;
+	header.version = ShaderBundleHeader::currentVersion;
+	header.entryCount = uint32_t(shaders.size());
+
+	std::vector<ShaderBundleEntry> entries(shaders.size());
+	std::string names;
+
+	for (size_t i = 0; i < shaders.size(); i++) {
+		entries[i].nameOffset = uint32_t(names.size());
+		entries[i].nameSize = uint32_t(shaders[i].name.size());
+		names += shaders[i].name;
+	}
+	header.namesSize = uint32_t(names.size());
+
+	std::vector<char> blobs(sizeof(header) + entries.size() * sizeof(ShaderBundleEntry) + names.size());
+	pad_to(blobs, 8);
+
+	for (size_t i = 0; i < shaders.size(); i++) {
+		const std::vector<char>& code = shaders[i].code;
+
+		entries[i].offset = blobs.size();
+		entries[i].size = code.size();
+		entries[i].hash = vkutil::hash_bytes(std::as_bytes(std::span<const char>(code)));
+
+		blobs.insert(blobs.end(), code.begin(), code.end());
+		pad_to(blobs, 8);
+	}
+
+	char* out = blobs.data();
+	std::memcpy(out, &header, sizeof(header));
+	std::memcpy(out + sizeof(header), entries.data(), entries.size() * sizeof(ShaderBundleEntry));
+	std::memcpy(out + sizeof(header) + entries.size() * sizeof(ShaderBundleEntry), names.data(), names.size());
+
+	// Scriviamo su un file temporaneo e lo rinominiamo, l'engine non vede mai un archivio a metà.
+	std::string outputPath = argv[2];
+	std::string tempPath = outputPath + ".tmp";
+
+	{
+		std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+		file.write(blobs.data(), std::streamsize(blobs.size()));
+
+		if (!file) {
+			std::fprintf(stderr, "Impossibile scrivere %s\n", tempPath.c_str());
+			return 1;
+		}
+	}
+
+	fs::rename(tempPath, outputPath, error);
+	if (error) {
+		std::fprintf(stderr, "Impossibile creare %s: %s\n", outputPath.c_str(), error.message().c_str());
+		return 1;
+	}
+
+	std::printf("%zu shader in %s (%zu byte)\n", shaders.size(), outputPath.c_str(), blobs.size());
+
+	return 0;
+}